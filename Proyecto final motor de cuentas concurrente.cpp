@@ -0,0 +1,1743 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Motor de cuentas del sistema bancario del proyecto final (la versión en
+// JavaScript está en "Proyecto final codigo interfaz bancaria.ccp"), con las
+// mismas operaciones pero pensado para muchos clientes a la vez:
+//
+// - Las cuentas viven en tablas hash fragmentadas: cada fragmento tiene su
+//   propio shared_mutex, así que buscar cuentas distintas no compite.
+// - Cada cuenta tiene su propio mutex. Una transferencia toma los dos en
+//   orden de id, de modo que dos transferencias cruzadas no se bloquean
+//   entre sí.
+// - No hay "sesión actual": iniciarSesion() devuelve el id de la cuenta y
+//   cada operación lo recibe.
+//
+// Los montos van en centavos (int64_t) para que las sumas sean exactas.
+//
+// Con un DiarioTransacciones (setDiario) cada operación queda en un diario
+// binario en disco antes de responder; el diario agrupa las escrituras de
+// todos los hilos en un solo fdatasync (group commit). tomarInstantanea()
+// guarda el estado de todas las cuentas sin detener las operaciones, y
+// recuperar() arranca desde la última instantánea más la cola del diario,
+// repartida por cuenta entre varios hilos.
+
+enum TipoTarjeta {
+    DEBITO,
+    CREDITO
+};
+
+enum TipoTransaccion {
+    DEPOSITO,
+    RETIRO,
+    TRANSFERENCIA_ENVIADA,
+    TRANSFERENCIA_RECIBIDA,
+    PAGO_DEBITO,
+    PAGO_CREDITO
+};
+
+const char* nombreTransaccion(TipoTransaccion tipo) {
+    switch (tipo) {
+        case DEPOSITO:               return "deposito";
+        case RETIRO:                 return "retiro";
+        case TRANSFERENCIA_ENVIADA:  return "transferencia_enviada";
+        case TRANSFERENCIA_RECIBIDA: return "transferencia_recibida";
+        case PAGO_DEBITO:            return "pago_debito";
+        case PAGO_CREDITO:           return "pago_credito";
+        default:                     return "?";
+    }
+}
+
+int64_t centavos(double pesos) {
+    return llround(pesos * 100);
+}
+
+struct DatosUsuario {
+    string nombre;
+    string email;
+    string telefono;
+    string password;
+    string documentoId;
+};
+
+struct Tarjeta {
+    string numero;
+    TipoTarjeta tipo;
+    string cvv;            // en claro solo en la copia que recibe el cliente al crearla
+    string hashCvv;        // lo que guarda el motor (ver hashSalado)
+    int64_t limite;        // solo crédito
+    int64_t saldoCredito;  // crédito disponible
+    bool activa;
+};
+
+struct Transaccion {
+    uint64_t id;
+    TipoTransaccion tipo;
+    uint64_t cuenta;
+    uint64_t contraparte;   // la otra cuenta en transferencias, 0 si no hay
+    int64_t monto;
+    int64_t saldoAnterior;  // en pagos con crédito, del crédito disponible
+    int64_t saldoNuevo;
+    string concepto;
+    chrono::system_clock::time_point fecha;
+};
+
+// CRC-32 (polinomio de Ethernet/zlib) para detectar registros cortados
+uint32_t crc32(uint32_t crc, const void* datos, size_t largo) {
+    static const auto tabla = []() {
+        array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    const uint8_t* p = static_cast<const uint8_t*>(datos);
+    crc = ~crc;
+    for (size_t i = 0; i < largo; ++i) crc = tabla[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// SHA-256 (FIPS 180-4), para los hashes de contraseñas y CVV
+array<uint8_t, 32> sha256(const void* datos, size_t largo) {
+    static const uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    auto rotar = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+    // Mensaje + 0x80 + ceros + largo en bits (big-endian), en bloques de 64 bytes
+    string mensaje(static_cast<const char*>(datos), largo);
+    mensaje += static_cast<char>(0x80);
+    while (mensaje.size() % 64 != 56) mensaje += '\0';
+    uint64_t bits = static_cast<uint64_t>(largo) * 8;
+    for (int i = 7; i >= 0; --i) mensaje += static_cast<char>(bits >> (i * 8));
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(mensaje.data());
+    for (size_t bloque = 0; bloque < mensaje.size(); bloque += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* b = p + bloque + i * 4;
+            w[i] = uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | b[3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotar(w[i - 15], 7) ^ rotar(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotar(w[i - 2], 17) ^ rotar(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = hh + (rotar(e, 6) ^ rotar(e, 11) ^ rotar(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (rotar(a, 2) ^ rotar(a, 13) ^ rotar(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+    array<uint8_t, 32> resultado;
+    for (int i = 0; i < 32; ++i) resultado[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+    return resultado;
+}
+
+string hexadecimal(const uint8_t* datos, size_t largo) {
+    static const char digitos[] = "0123456789abcdef";
+    string texto;
+    for (size_t i = 0; i < largo; ++i) {
+        texto += digitos[datos[i] >> 4];
+        texto += digitos[datos[i] & 15];
+    }
+    return texto;
+}
+
+// Contraseñas y CVV no se guardan en claro (ni en memoria, ni en el diario,
+// ni en las instantáneas): se guarda "sal$hash", con la sal en hexadecimal y
+// el SHA-256 de sal + secreto. La sal es distinta por secreto, así dos
+// cuentas con la misma contraseña no tienen el mismo hash. No se itera el
+// hash (PBKDF2, bcrypt): registrar una cuenta tiene que seguir costando
+// microsegundos.
+string hashSalado(const string& secreto, const string& sal) {
+    array<uint8_t, 32> digesto = sha256((sal + secreto).data(), sal.size() + secreto.size());
+    return sal + '$' + hexadecimal(digesto.data(), digesto.size());
+}
+
+// Compara sin salir en el primer byte distinto
+bool verificarSecreto(const string& secreto, const string& guardado) {
+    size_t separador = guardado.find('$');
+    if (separador == string::npos) return false;
+    string calculado = hashSalado(secreto, guardado.substr(0, separador));
+    if (calculado.size() != guardado.size()) return false;
+    unsigned diferencia = 0;
+    for (size_t i = 0; i < calculado.size(); ++i) diferencia |= static_cast<unsigned char>(calculado[i] ^ guardado[i]);
+    return diferencia == 0;
+}
+
+enum TipoRegistro : uint16_t {
+    REG_ALTA_CUENTA,     // datos: nombre, email, teléfono, hash de la contraseña, documento y número de cuenta
+    REG_ALTA_TARJETA,    // otra: tipo; monto: límite; datos: número y hash del cvv
+    REG_DEPOSITO,
+    REG_RETIRO,
+    REG_TRANSFERENCIA,   // cuenta: origen; otra: destino
+    REG_PAGO_DEBITO,     // otra: índice de la tarjeta en la cuenta
+    REG_PAGO_CREDITO
+};
+
+// Cada registro del diario es esta cabecera seguida de largoDatos bytes. El
+// CRC cubre el resto de la cabecera y los datos.
+struct CabeceraRegistro {
+    uint32_t crc;
+    uint16_t tipo;
+    uint16_t largoDatos;
+    uint64_t cuenta;
+    uint64_t otra;
+    int64_t monto;
+    int64_t fecha;     // ns desde la época (system_clock)
+};
+static_assert(sizeof(CabeceraRegistro) == 40, "la cabecera se escribe tal cual en disco");
+
+bool escribirTodo(int fd, const char* datos, size_t largo) {
+    while (largo > 0) {
+        ssize_t escrito = ::write(fd, datos, largo);
+        if (escrito < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += escrito;
+        largo -= static_cast<size_t>(escrito);
+    }
+    return true;
+}
+
+// Completa largoDatos y el CRC de la cabecera
+void sellarRegistro(CabeceraRegistro& cabecera, string_view datos) {
+    cabecera.largoDatos = static_cast<uint16_t>(datos.size());
+    uint32_t crc = crc32(0, reinterpret_cast<const char*>(&cabecera) + 4, sizeof(cabecera) - 4);
+    cabecera.crc = crc32(crc, datos.data(), datos.size());
+}
+
+// Número de registros escritos en el diario y el tamaño en bytes que ocupan
+struct PosicionDiario {
+    uint64_t secuencia = 0;
+    uint64_t bytes = 0;
+};
+
+struct ConfigDiario {
+    // Cuánto espera el escritor a que se junten más registros antes de
+    // sincronizar (0 = sincroniza en cuanto hay algo; mientras tanto se
+    // juntan los que lleguen)
+    chrono::microseconds ventana{0};
+    // Con tantos bytes pendientes se sincroniza sin esperar la ventana
+    size_t maxBytes = 1 << 20;
+};
+
+// Diario de solo agregado con group commit. Los hilos agregan registros a un
+// buffer compartido y reciben un número de secuencia; un hilo escritor
+// escribe el buffer completo con un solo write y un solo fdatasync, y
+// despierta a los que esperaban ese lote. Lo durable siempre es un prefijo
+// del diario. Las secuencias son la posición del registro en el archivo,
+// contando desde 1.
+class DiarioTransacciones {
+private:
+    int fd;
+    ConfigDiario config;
+
+    mutex mtx;
+    condition_variable hayDatos;
+    condition_variable hayDurables;
+    string pendiente;           // registros que aún no se escriben
+    string escribiendo;         // el lote que está escribiendo el escritor
+    uint64_t ultimaSecuencia = 0;
+    uint64_t secuenciaDurable = 0;
+    uint64_t tamano = 0;        // bytes del archivo más los pendientes
+    bool terminar = false;
+    atomic<bool> fallo{false};  // se escribe con mtx tomado; una vez puesto no se quita
+    thread escritor;
+
+    atomic<size_t> numLotes{0};
+    atomic<size_t> numBytes{0};
+
+    void trabajar() {
+        unique_lock<mutex> lock(mtx);
+        for (;;) {
+            hayDatos.wait(lock, [this]() { return !pendiente.empty() || terminar; });
+            if (pendiente.empty()) break;
+            if (config.ventana.count() > 0 && !terminar) {
+                hayDatos.wait_for(lock, config.ventana,
+                                  [this]() { return pendiente.size() >= config.maxBytes || terminar; });
+            }
+            swap(pendiente, escribiendo);
+            uint64_t hasta = ultimaSecuencia;
+            lock.unlock();
+
+            bool ok = escribirTodo(fd, escribiendo.data(), escribiendo.size()) && ::fdatasync(fd) == 0;
+            numLotes.fetch_add(1, memory_order_relaxed);
+            numBytes.fetch_add(escribiendo.size(), memory_order_relaxed);
+            escribiendo.clear();
+
+            lock.lock();
+            if (!ok) fallo.store(true, memory_order_release);
+            secuenciaDurable = hasta;
+            hayDurables.notify_all();
+        }
+    }
+
+public:
+    // Un diario que ya tiene registros se abre con la secuencia final que
+    // devolvió MotorCuentas::recuperar()
+    DiarioTransacciones(const string& ruta, const ConfigDiario& cfg = ConfigDiario(), uint64_t secuenciaInicial = 0)
+        : config(cfg), ultimaSecuencia(secuenciaInicial), secuenciaDurable(secuenciaInicial) {
+        fd = ::open(ruta.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) throw runtime_error("No se pudo abrir el diario " + ruta + ": " + strerror(errno));
+        struct stat info;
+        if (::fstat(fd, &info) == 0) tamano = static_cast<uint64_t>(info.st_size);
+        pendiente.reserve(config.maxBytes);
+        escribiendo.reserve(config.maxBytes);
+        escritor = thread(&DiarioTransacciones::trabajar, this);
+    }
+
+    // Escribe lo pendiente antes de cerrar
+    ~DiarioTransacciones() {
+        {
+            lock_guard<mutex> lock(mtx);
+            terminar = true;
+        }
+        hayDatos.notify_one();
+        escritor.join();
+        ::close(fd);
+    }
+
+    // Agrega un registro y devuelve su número de secuencia. Todavía no es
+    // durable: hay que llamar a esperarDurable().
+    uint64_t agregar(CabeceraRegistro cabecera, string_view datos) {
+        sellarRegistro(cabecera, datos);
+
+        lock_guard<mutex> lock(mtx);
+        bool estabaVacio = pendiente.empty();
+        pendiente.append(reinterpret_cast<const char*>(&cabecera), sizeof(cabecera));
+        pendiente.append(datos.data(), datos.size());
+        tamano += sizeof(cabecera) + datos.size();
+        if (estabaVacio || pendiente.size() >= config.maxBytes) hayDatos.notify_one();
+        return ++ultimaSecuencia;
+    }
+
+    // Bloquea hasta que el registro 'secuencia' (y todos los anteriores)
+    // esté en disco. Si la escritura o el fdatasync fallaron, lanza: el
+    // diario ya no es confiable.
+    void esperarDurable(uint64_t secuencia) {
+        unique_lock<mutex> lock(mtx);
+        hayDurables.wait(lock, [&]() { return secuenciaDurable >= secuencia || fallo; });
+        if (fallo) throw runtime_error("No se pudo escribir el diario");
+    }
+
+    // true si alguna escritura o fdatasync falló. No se lee bajo mtx: el
+    // motor lo consulta en cada operación.
+    bool fallido() const { return fallo.load(memory_order_acquire); }
+
+    // Hasta dónde llega el diario, contando lo que aún no es durable
+    PosicionDiario posicion() {
+        lock_guard<mutex> lock(mtx);
+        return {ultimaSecuencia, tamano};
+    }
+
+    size_t lotes() const { return numLotes.load(); }
+    size_t bytes() const { return numBytes.load(); }
+};
+
+// Lee números y textos de un buffer binario; lanza si se sale del buffer
+class LectorBinario {
+private:
+    const char* p;
+    const char* fin;
+
+public:
+    LectorBinario(const char* inicio, size_t largo) : p(inicio), fin(inicio + largo) {}
+
+    template <typename T>
+    T numero() {
+        if (static_cast<size_t>(fin - p) < sizeof(T)) throw runtime_error("Instantánea corrupta");
+        T valor;
+        memcpy(&valor, p, sizeof(T));
+        p += sizeof(T);
+        return valor;
+    }
+
+    string texto() {
+        uint32_t largo = numero<uint32_t>();
+        if (static_cast<size_t>(fin - p) < largo) throw runtime_error("Instantánea corrupta");
+        string valor(p, largo);
+        p += largo;
+        return valor;
+    }
+};
+
+template <typename T>
+void escribirNumero(string& destino, T valor) {
+    destino.append(reinterpret_cast<const char*>(&valor), sizeof(T));
+}
+
+void escribirTexto(string& destino, const string& texto) {
+    escribirNumero<uint32_t>(destino, static_cast<uint32_t>(texto.size()));
+    destino += texto;
+}
+
+// Separa los campos de un registro unidos con '\0'
+vector<string> camposRegistro(string_view datos) {
+    vector<string> campos;
+    size_t inicio = 0;
+    for (;;) {
+        size_t fin = datos.find('\0', inicio);
+        campos.emplace_back(datos.substr(inicio, fin == string_view::npos ? string_view::npos : fin - inicio));
+        if (fin == string_view::npos) return campos;
+        inicio = fin + 1;
+    }
+}
+
+struct EstadisticasRecuperacion {
+    size_t cuentasInstantanea = 0;
+    size_t registrosLeidos = 0;       // de la cola del diario
+    size_t registrosAplicados = 0;    // por cuenta (una transferencia cuenta dos); los demás ya estaban en la instantánea
+    size_t bytesDescartados = 0;      // registro final cortado por una caída
+    uint64_t secuenciaFinal = 0;      // para abrir el diario de nuevo
+    double segundosInstantanea = 0;
+    double segundosDiario = 0;
+};
+
+struct ConfigMotor {
+    size_t fragmentos = 64;            // se redondea a potencia de dos
+    size_t historialPorCuenta = 32;    // últimas transacciones que guarda cada cuenta
+    int64_t saldoInicial = 100000;     // $1000.00 de bienvenida
+    int64_t limiteCredito = 500000;    // $5000.00
+};
+
+class MotorCuentas {
+public:
+    // canal es "sms" o "email"; destino, el teléfono o el correo
+    using Notificador = function<void(const char* canal, const string& destino, const string& mensaje)>;
+
+private:
+    // Alineada a línea de caché: los mutex de cuentas vecinas no comparten línea
+    struct alignas(64) Cuenta {
+        mutex mtx;
+        uint64_t id;
+        DatosUsuario datos;      // no cambia después del registro; password queda vacío
+        string hashPassword;     // ver hashSalado
+        string numeroCuenta;
+        bool activa = true;
+        int64_t saldo = 0;
+        vector<Tarjeta> tarjetas;
+        vector<Transaccion> historial;   // circular, de a lo más historialPorCuenta
+        size_t siguienteHistorial = 0;
+        uint64_t secuencia = 0;          // último registro del diario aplicado a la cuenta
+    };
+
+    struct alignas(64) FragmentoCuentas {
+        mutable shared_mutex mtx;
+        unordered_map<uint64_t, unique_ptr<Cuenta>> cuentas;
+    };
+
+    struct alignas(64) FragmentoEmails {
+        mutable shared_mutex mtx;
+        unordered_map<string, uint64_t> ids;
+    };
+
+    ConfigMotor config;
+    size_t mascara;
+    vector<FragmentoCuentas> porId;
+    vector<FragmentoEmails> porEmail;
+    atomic<uint64_t> siguienteCuenta{1};
+    atomic<uint64_t> siguienteTransaccion{1};
+    Notificador notificador;
+    DiarioTransacciones* diario = nullptr;
+
+    thread instantaneas;
+    mutex mtxInstantaneas;
+    condition_variable cvInstantaneas;
+    bool pararInstantaneas = false;
+    atomic<size_t> numInstantaneas{0};   // las que tomó instantaneasCada()
+
+    static size_t potenciaDeDos(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // Las cuentas nunca se borran, así que el puntero sigue siendo válido
+    // después de soltar el fragmento
+    Cuenta* buscar(uint64_t id) const {
+        const FragmentoCuentas& fragmento = porId[id & mascara];
+        shared_lock<shared_mutex> lock(fragmento.mtx);
+        auto it = fragmento.cuentas.find(id);
+        return it == fragmento.cuentas.end() ? nullptr : it->second.get();
+    }
+
+    Cuenta& cuenta(uint64_t id, const char* error = "Usuario no encontrado") const {
+        Cuenta* c = buscar(id);
+        if (!c) throw runtime_error(error);
+        return *c;
+    }
+
+    FragmentoEmails& fragmentoEmail(const string& email) {
+        return porEmail[hash<string>()(email) & mascara];
+    }
+
+    static mt19937_64& generador() {
+        thread_local mt19937_64 rng(random_device{}());
+        return rng;
+    }
+
+    static string nuevaSal() {
+        uint64_t numeros[2] = {generador()(), generador()()};
+        return hexadecimal(reinterpret_cast<const uint8_t*>(numeros), sizeof(numeros));
+    }
+
+    static string digitosAleatorios(size_t n) {
+        string digitos(n, '0');
+        for (char& d : digitos) d = static_cast<char>('0' + generador()() % 10);
+        return digitos;
+    }
+
+    Tarjeta crearTarjeta(TipoTarjeta tipo) const {
+        Tarjeta tarjeta;
+        tarjeta.numero = "4" + digitosAleatorios(15);
+        tarjeta.tipo = tipo;
+        tarjeta.cvv = to_string(100 + generador()() % 900);
+        tarjeta.hashCvv = hashSalado(tarjeta.cvv, nuevaSal());
+        tarjeta.limite = tipo == CREDITO ? config.limiteCredito : 0;
+        tarjeta.saldoCredito = tarjeta.limite;
+        tarjeta.activa = true;
+        return tarjeta;
+    }
+
+    // Se llama con c.mtx tomado
+    Transaccion registrar(Cuenta& c, TipoTransaccion tipo, int64_t monto, int64_t anterior,
+                          int64_t nuevo, uint64_t contraparte, const string& concepto) {
+        Transaccion t;
+        t.id = siguienteTransaccion.fetch_add(1, memory_order_relaxed);
+        t.tipo = tipo;
+        t.cuenta = c.id;
+        t.contraparte = contraparte;
+        t.monto = monto;
+        t.saldoAnterior = anterior;
+        t.saldoNuevo = nuevo;
+        t.concepto = concepto;
+        t.fecha = chrono::system_clock::now();
+
+        if (config.historialPorCuenta == 0) return t;
+        if (c.historial.size() < config.historialPorCuenta) {
+            c.historial.push_back(t);
+        } else {
+            c.historial[c.siguienteHistorial] = t;
+        }
+        c.siguienteHistorial = (c.siguienteHistorial + 1) % config.historialPorCuenta;
+        return t;
+    }
+
+    static void validarMonto(int64_t monto) {
+        if (monto <= 0) throw invalid_argument("El monto debe ser positivo");
+    }
+
+    static string pesos(int64_t monto) {
+        char texto[32];
+        snprintf(texto, sizeof(texto), "$%lld.%02lld", static_cast<long long>(monto / 100),
+                 static_cast<long long>(llabs(monto % 100)));
+        return texto;
+    }
+
+    // Se llama con los locks de las cuentas tomados, para que el orden en el
+    // diario sea el mismo en que se aplicaron los cambios. Devuelve 0 si no
+    // hay diario.
+    // También marca las cuentas con la secuencia del registro.
+    uint64_t anotar(TipoRegistro tipo, Cuenta& c, uint64_t otra, int64_t monto, string_view datos,
+                    Cuenta* destino = nullptr) {
+        if (!diario) return 0;
+        CabeceraRegistro cabecera = {};
+        cabecera.tipo = tipo;
+        cabecera.cuenta = c.id;
+        cabecera.otra = otra;
+        cabecera.monto = monto;
+        cabecera.fecha = chrono::duration_cast<chrono::nanoseconds>(
+                             chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t secuencia = diario->agregar(cabecera, datos.substr(0, UINT16_MAX));
+        c.secuencia = secuencia;
+        if (destino) destino->secuencia = secuencia;
+        return secuencia;
+    }
+
+    // Se llama con el lock de la cuenta tomado, antes de cambiar nada. Después
+    // de un error del diario el motor queda de solo lectura: las operaciones
+    // lanzan sin aplicar nada, así un cliente que reintenta no mueve el
+    // dinero dos veces.
+    void exigirDiario() const {
+        if (diario && diario->fallido()) {
+            throw runtime_error("El diario falló: el motor solo acepta consultas");
+        }
+    }
+
+    // Se llama sin locks, antes de responder. Mientras tanto otros hilos ya
+    // pueden ver el cambio en memoria. Si el diario falla antes de que el
+    // registro sea durable, lanza aunque el cambio ya esté aplicado en
+    // memoria (y quizá no en disco): el cliente no sabe si la operación
+    // quedó, y el motor deja de aceptar cambios (ver exigirDiario). Con el
+    // registro también se pierden los posteriores que dependían de él.
+    void confirmar(uint64_t secuencia) {
+        if (secuencia != 0) diario->esperarDurable(secuencia);
+    }
+
+    // Versión 2: contraseñas y CVV como hashSalado (la 1 los llevaba en claro)
+    static const uint64_t MAGIA_INSTANTANEA = 0x32504E5341544300ull;   // "\0CTASNP2"
+
+    // Agrega una cuenta ya armada (al recuperar)
+    void publicar(unique_ptr<Cuenta> c) {
+        uint64_t id = c->id;
+        FragmentoEmails& emails = fragmentoEmail(c->datos.email);
+        unique_lock<shared_mutex> lockEmail(emails.mtx);
+        emails.ids.emplace(c->datos.email, id);
+        FragmentoCuentas& cuentas = porId[id & mascara];
+        unique_lock<shared_mutex> lockCuentas(cuentas.mtx);
+        cuentas.cuentas.emplace(id, std::move(c));
+    }
+
+    // Aplica un registro de la cola del diario a una cuenta, si la cuenta no
+    // lo tenía ya (su secuencia es menor). En una transferencia, comoDestino
+    // indica cuál de las dos cuentas es c.
+    static bool aplicar(const CabeceraRegistro& cabecera, string_view datos, uint64_t secuencia,
+                        Cuenta& c, bool comoDestino) {
+        if (secuencia <= c.secuencia) return false;
+        switch (cabecera.tipo) {
+            case REG_ALTA_TARJETA: {
+                vector<string> campos = camposRegistro(datos);
+                Tarjeta tarjeta;
+                tarjeta.numero = campos[0];
+                tarjeta.tipo = static_cast<TipoTarjeta>(cabecera.otra);
+                tarjeta.hashCvv = campos.size() > 1 ? campos[1] : "";
+                tarjeta.limite = cabecera.monto;
+                tarjeta.saldoCredito = cabecera.monto;
+                tarjeta.activa = true;
+                c.tarjetas.push_back(tarjeta);
+                break;
+            }
+            case REG_DEPOSITO:      c.saldo += cabecera.monto; break;
+            case REG_RETIRO:        c.saldo -= cabecera.monto; break;
+            case REG_TRANSFERENCIA: c.saldo += comoDestino ? cabecera.monto : -cabecera.monto; break;
+            case REG_PAGO_DEBITO:   c.saldo -= cabecera.monto; break;
+            case REG_PAGO_CREDITO:
+                if (cabecera.otra < c.tarjetas.size()) c.tarjetas[cabecera.otra].saldoCredito -= cabecera.monto;
+                break;
+            default: break;
+        }
+        c.secuencia = secuencia;
+        return true;
+    }
+
+    static string datosTarjeta(const Tarjeta& tarjeta) {
+        return tarjeta.numero + '\0' + tarjeta.hashCvv;
+    }
+
+    // Se llama sin locks: la notificación puede tardar
+    void notificar(const char* canal, const Cuenta& c, const string& mensaje) {
+        if (!notificador) return;
+        notificador(canal, strcmp(canal, "sms") == 0 ? c.datos.telefono : c.datos.email, mensaje);
+    }
+
+public:
+    MotorCuentas(const ConfigMotor& cfg = ConfigMotor())
+        : config(cfg), mascara(potenciaDeDos(max<size_t>(1, cfg.fragmentos)) - 1),
+          porId(mascara + 1), porEmail(mascara + 1) {}
+
+    ~MotorCuentas() {
+        detenerInstantaneas();
+    }
+
+    // Se configura antes de empezar a operar
+    void setNotificador(Notificador n) { notificador = std::move(n); }
+
+    // Desde aquí cada operación responde hasta que su registro es durable.
+    // Se configura antes de empezar a operar; el diario debe vivir más que el motor.
+    void setDiario(DiarioTransacciones* d) { diario = d; }
+
+    // Devuelve el id de la cuenta nueva, que ya trae su tarjeta de débito. Si
+    // se pide, copia esa tarjeta en 'debito': es la única vez que su CVV se
+    // puede ver en claro.
+    uint64_t registrarUsuario(const DatosUsuario& datos, Tarjeta* debito = nullptr) {
+        Cuenta* nueva;
+        uint64_t secuencia = 0;
+        string hashPassword = hashSalado(datos.password, nuevaSal());
+        Tarjeta tarjeta = crearTarjeta(DEBITO);
+        {
+            FragmentoEmails& emails = fragmentoEmail(datos.email);
+            unique_lock<shared_mutex> lockEmail(emails.mtx);
+            if (emails.ids.count(datos.email)) throw runtime_error("El email ya está registrado");
+            exigirDiario();
+
+            auto c = make_unique<Cuenta>();
+            c->id = siguienteCuenta.fetch_add(1, memory_order_relaxed);
+            c->datos = datos;
+            c->datos.password.clear();
+            c->hashPassword = std::move(hashPassword);
+            char numero[24];
+            snprintf(numero, sizeof(numero), "4000%08llu", static_cast<unsigned long long>(c->id % 100000000));
+            c->numeroCuenta = numero;
+            c->saldo = config.saldoInicial;
+            c->tarjetas.push_back(tarjeta);
+            c->tarjetas.back().cvv.clear();
+            nueva = c.get();
+
+            // La cuenta se publica con su lock tomado y después se anota en
+            // el diario: ninguna operación la usa antes de su alta en el
+            // diario, y una instantánea que empiece después del alta ya la
+            // encuentra en porId (la copia al poder tomar su lock).
+            lock_guard<mutex> lockCuenta(nueva->mtx);
+            // Orden fijo: fragmento de email y luego fragmento de id (este
+            // último nunca se toma junto con otro)
+            FragmentoCuentas& cuentas = porId[nueva->id & mascara];
+            {
+                unique_lock<shared_mutex> lockCuentas(cuentas.mtx);
+                cuentas.cuentas.emplace(nueva->id, std::move(c));
+            }
+            emails.ids.emplace(datos.email, nueva->id);
+
+            if (diario) {
+                string registro = datos.nombre + '\0' + datos.email + '\0' + datos.telefono + '\0' +
+                                  nueva->hashPassword + '\0' + datos.documentoId + '\0' + nueva->numeroCuenta;
+                anotar(REG_ALTA_CUENTA, *nueva, 0, nueva->saldo, registro);
+                secuencia = anotar(REG_ALTA_TARJETA, *nueva, DEBITO, 0, datosTarjeta(nueva->tarjetas[0]));
+            }
+        }
+        confirmar(secuencia);
+
+        notificar("sms", *nueva, "¡Bienvenido " + datos.nombre + "! Tu cuenta ha sido creada exitosamente. Número: " +
+                                     nueva->numeroCuenta);
+        notificar("email", *nueva, "Cuenta bancaria creada. Saldo inicial: " + pesos(config.saldoInicial));
+        if (debito) *debito = tarjeta;
+        return nueva->id;
+    }
+
+    uint64_t buscarPorEmail(const string& email, const char* error = "Usuario no encontrado") {
+        FragmentoEmails& emails = fragmentoEmail(email);
+        shared_lock<shared_mutex> lock(emails.mtx);
+        auto it = emails.ids.find(email);
+        if (it == emails.ids.end()) throw runtime_error(error);
+        return it->second;
+    }
+
+    uint64_t iniciarSesion(const string& email, const string& password) {
+        Cuenta& c = cuenta(buscarPorEmail(email));
+        if (!verificarSecreto(password, c.hashPassword)) throw runtime_error("Contraseña incorrecta");
+        {
+            lock_guard<mutex> lock(c.mtx);
+            if (!c.activa) throw runtime_error("Cuenta desactivada");
+        }
+        notificar("sms", c, "Inicio de sesión detectado");
+        return c.id;
+    }
+
+    int64_t consultarSaldo(uint64_t id) const {
+        Cuenta& c = cuenta(id);
+        lock_guard<mutex> lock(c.mtx);
+        return c.saldo;
+    }
+
+    // Copia de las tarjetas de la cuenta, sin CVV ni su hash
+    vector<Tarjeta> tarjetas(uint64_t id) const {
+        Cuenta& c = cuenta(id);
+        vector<Tarjeta> copia;
+        {
+            lock_guard<mutex> lock(c.mtx);
+            copia = c.tarjetas;
+        }
+        for (Tarjeta& tarjeta : copia) tarjeta.hashCvv.clear();
+        return copia;
+    }
+
+    // La tarjeta que se devuelve trae el CVV en claro; la cuenta solo guarda su hash
+    Tarjeta solicitarTarjetaCredito(uint64_t id) {
+        Cuenta& c = cuenta(id);
+        Tarjeta tarjeta = crearTarjeta(CREDITO);
+        uint64_t secuencia;
+        {
+            lock_guard<mutex> lock(c.mtx);
+            exigirDiario();
+            c.tarjetas.push_back(tarjeta);
+            c.tarjetas.back().cvv.clear();
+            secuencia = anotar(REG_ALTA_TARJETA, c, CREDITO, tarjeta.limite, datosTarjeta(tarjeta));
+        }
+        confirmar(secuencia);
+        notificar("email", c, "Nueva tarjeta de crédito aprobada. Número: **** **** **** " + tarjeta.numero.substr(12));
+        return tarjeta;
+    }
+
+    Transaccion realizarDeposito(uint64_t id, int64_t monto, const string& concepto = "Depósito") {
+        validarMonto(monto);
+        Cuenta& c = cuenta(id);
+        Transaccion t;
+        uint64_t secuencia;
+        {
+            lock_guard<mutex> lock(c.mtx);
+            exigirDiario();
+            c.saldo += monto;
+            t = registrar(c, DEPOSITO, monto, c.saldo - monto, c.saldo, 0, concepto);
+            secuencia = anotar(REG_DEPOSITO, c, 0, monto, concepto);
+        }
+        confirmar(secuencia);
+        if (notificador) {
+            notificar("sms", c, "Depósito realizado: " + pesos(monto) + ". Nuevo saldo: " + pesos(t.saldoNuevo));
+        }
+        return t;
+    }
+
+    Transaccion realizarRetiro(uint64_t id, int64_t monto, const string& concepto = "Retiro") {
+        validarMonto(monto);
+        Cuenta& c = cuenta(id);
+        Transaccion t;
+        uint64_t secuencia;
+        {
+            lock_guard<mutex> lock(c.mtx);
+            if (monto > c.saldo) throw runtime_error("Saldo insuficiente");
+            exigirDiario();
+            c.saldo -= monto;
+            t = registrar(c, RETIRO, monto, c.saldo + monto, c.saldo, 0, concepto);
+            secuencia = anotar(REG_RETIRO, c, 0, monto, concepto);
+        }
+        confirmar(secuencia);
+        if (notificador) {
+            notificar("sms", c, "Retiro realizado: " + pesos(monto) + ". Nuevo saldo: " + pesos(t.saldoNuevo));
+        }
+        return t;
+    }
+
+    // Devuelve {envío, recepción}
+    pair<Transaccion, Transaccion> realizarTransferencia(uint64_t id, uint64_t idDestino, int64_t monto,
+                                                         const string& concepto = "Transferencia") {
+        validarMonto(monto);
+        Cuenta& origen = cuenta(id);
+        Cuenta& destino = cuenta(idDestino, "Usuario destinatario no encontrado");
+        if (&origen == &destino) throw invalid_argument("No se puede transferir a la misma cuenta");
+
+        pair<Transaccion, Transaccion> resultado;
+        uint64_t secuencia;
+        {
+            // Siempre primero la cuenta de menor id
+            Cuenta& primera = origen.id < destino.id ? origen : destino;
+            Cuenta& segunda = origen.id < destino.id ? destino : origen;
+            lock_guard<mutex> lock1(primera.mtx);
+            lock_guard<mutex> lock2(segunda.mtx);
+
+            if (monto > origen.saldo) throw runtime_error("Saldo insuficiente");
+            exigirDiario();
+            origen.saldo -= monto;
+            destino.saldo += monto;
+            resultado.first = registrar(origen, TRANSFERENCIA_ENVIADA, monto, origen.saldo + monto,
+                                        origen.saldo, destino.id, concepto);
+            resultado.second = registrar(destino, TRANSFERENCIA_RECIBIDA, monto, destino.saldo - monto,
+                                         destino.saldo, origen.id, concepto);
+            secuencia = anotar(REG_TRANSFERENCIA, origen, destino.id, monto, concepto, &destino);
+        }
+        confirmar(secuencia);
+        if (notificador) {
+            notificar("sms", origen, "Transferencia enviada: " + pesos(monto) + " a " + destino.datos.email +
+                                         ". Nuevo saldo: " + pesos(resultado.first.saldoNuevo));
+            notificar("sms", destino, "Transferencia recibida: " + pesos(monto) + " de " + origen.datos.email +
+                                          ". Nuevo saldo: " + pesos(resultado.second.saldoNuevo));
+        }
+        return resultado;
+    }
+
+    pair<Transaccion, Transaccion> realizarTransferencia(uint64_t id, const string& emailDestino, int64_t monto,
+                                                         const string& concepto = "Transferencia") {
+        return realizarTransferencia(id, buscarPorEmail(emailDestino, "Usuario destinatario no encontrado"),
+                                     monto, concepto);
+    }
+
+    Transaccion pagarConTarjeta(uint64_t id, const string& numeroTarjeta, int64_t monto,
+                                const string& comercio, const string& cvv) {
+        validarMonto(monto);
+        Cuenta& c = cuenta(id);
+        Transaccion t;
+        uint64_t secuencia;
+        {
+            lock_guard<mutex> lock(c.mtx);
+            auto tarjeta = find_if(c.tarjetas.begin(), c.tarjetas.end(),
+                                   [&](const Tarjeta& x) { return x.numero == numeroTarjeta; });
+            if (tarjeta == c.tarjetas.end()) throw runtime_error("Tarjeta no encontrada");
+            if (!tarjeta->activa) throw runtime_error("Tarjeta desactivada");
+            if (!verificarSecreto(cvv, tarjeta->hashCvv)) throw runtime_error("CVV incorrecto");
+            exigirDiario();
+
+            if (tarjeta->tipo == DEBITO) {
+                if (monto > c.saldo) throw runtime_error("Saldo insuficiente");
+                c.saldo -= monto;
+                t = registrar(c, PAGO_DEBITO, monto, c.saldo + monto, c.saldo, 0, "Pago en " + comercio);
+                secuencia = anotar(REG_PAGO_DEBITO, c, tarjeta - c.tarjetas.begin(), monto, t.concepto);
+            } else {
+                if (monto > tarjeta->saldoCredito) throw runtime_error("Límite de crédito excedido");
+                tarjeta->saldoCredito -= monto;
+                t = registrar(c, PAGO_CREDITO, monto, tarjeta->saldoCredito + monto, tarjeta->saldoCredito, 0,
+                              "Pago en " + comercio);
+                secuencia = anotar(REG_PAGO_CREDITO, c, tarjeta - c.tarjetas.begin(), monto, t.concepto);
+            }
+        }
+        confirmar(secuencia);
+        if (notificador) {
+            notificar("sms", c, "Pago realizado: " + pesos(monto) + " en " + comercio + " con tarjeta **** " +
+                                    numeroTarjeta.substr(numeroTarjeta.size() - 4));
+        }
+        return t;
+    }
+
+    // Las últimas transacciones de la cuenta, la más reciente primero
+    vector<Transaccion> verHistorial(uint64_t id, size_t limite = 10) const {
+        Cuenta& c = cuenta(id);
+        lock_guard<mutex> lock(c.mtx);
+        vector<Transaccion> historial;
+        size_t n = c.historial.size();
+        for (size_t i = 0; i < min(limite, n); ++i) {
+            historial.push_back(c.historial[(c.siguienteHistorial + n - 1 - i) % n]);
+        }
+        return historial;
+    }
+
+    size_t numCuentas() const {
+        return siguienteCuenta.load() - 1;
+    }
+
+    // Guarda todas las cuentas (saldos, tarjetas y crédito) en 'ruta' sin
+    // detener las operaciones. Cada cuenta se copia bajo su propio lock junto
+    // con la secuencia del último registro del diario que la modificó; al
+    // recuperar, la cola del diario se lee desde donde estaba el diario al
+    // empezar y a cada cuenta solo se le aplican los registros posteriores a
+    // su secuencia. El archivo se escribe aparte y se renombra cuando todo lo
+    // que contiene ya es durable en el diario. El historial no se guarda.
+    void tomarInstantanea(const string& ruta) {
+        PosicionDiario inicio = diario ? diario->posicion() : PosicionDiario();
+        string temporal = ruta + ".tmp";
+        int fd = ::open(temporal.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw runtime_error("No se pudo crear " + temporal + ": " + strerror(errno));
+
+        string buffer;
+        uint32_t crc = 0;
+        bool ok = true;
+        auto volcar = [&]() {
+            crc = crc32(crc, buffer.data(), buffer.size());
+            ok = ok && escribirTodo(fd, buffer.data(), buffer.size());
+            buffer.clear();
+        };
+
+        escribirNumero(buffer, MAGIA_INSTANTANEA);
+        escribirNumero(buffer, inicio.secuencia);
+        escribirNumero(buffer, inicio.bytes);
+        uint64_t numCuentas = 0;
+        uint64_t maxSecuencia = inicio.secuencia;
+        vector<Cuenta*> lista;
+        for (FragmentoCuentas& fragmento : porId) {
+            // El fragmento se suelta antes de tomar las cuentas
+            lista.clear();
+            {
+                shared_lock<shared_mutex> lock(fragmento.mtx);
+                for (auto& par : fragmento.cuentas) lista.push_back(par.second.get());
+            }
+            for (Cuenta* c : lista) {
+                lock_guard<mutex> lock(c->mtx);
+                escribirNumero(buffer, c->id);
+                escribirNumero(buffer, c->secuencia);
+                escribirNumero(buffer, c->saldo);
+                escribirNumero<uint8_t>(buffer, c->activa);
+                escribirTexto(buffer, c->datos.nombre);
+                escribirTexto(buffer, c->datos.email);
+                escribirTexto(buffer, c->datos.telefono);
+                escribirTexto(buffer, c->hashPassword);
+                escribirTexto(buffer, c->datos.documentoId);
+                escribirTexto(buffer, c->numeroCuenta);
+                escribirNumero<uint32_t>(buffer, static_cast<uint32_t>(c->tarjetas.size()));
+                for (const Tarjeta& tarjeta : c->tarjetas) {
+                    escribirNumero<uint8_t>(buffer, tarjeta.tipo);
+                    escribirNumero<uint8_t>(buffer, tarjeta.activa);
+                    escribirNumero(buffer, tarjeta.limite);
+                    escribirNumero(buffer, tarjeta.saldoCredito);
+                    escribirTexto(buffer, tarjeta.numero);
+                    escribirTexto(buffer, tarjeta.hashCvv);
+                }
+                maxSecuencia = max(maxSecuencia, c->secuencia);
+                numCuentas++;
+            }
+            if (buffer.size() >= (1 << 20)) volcar();
+        }
+        escribirNumero(buffer, numCuentas);
+        volcar();
+        escribirNumero(buffer, crc);
+        ok = ok && escribirTodo(fd, buffer.data(), buffer.size());
+
+        // Nada de la instantánea puede ir por delante del diario en disco
+        if (diario && ok) diario->esperarDurable(maxSecuencia);
+        ok = ok && ::fdatasync(fd) == 0;
+        ::close(fd);
+        if (!ok || ::rename(temporal.c_str(), ruta.c_str()) != 0) {
+            int error = errno;
+            ::unlink(temporal.c_str());
+            throw runtime_error("No se pudo escribir la instantánea " + ruta + ": " + strerror(error));
+        }
+
+        // El renombrado también tiene que llegar a disco
+        size_t barra = ruta.rfind('/');
+        string directorio = barra == string::npos ? "." : barra == 0 ? "/" : ruta.substr(0, barra);
+        int fdDirectorio = ::open(directorio.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fdDirectorio >= 0) {
+            ::fsync(fdDirectorio);
+            ::close(fdDirectorio);
+        }
+    }
+
+    // Toma una instantánea en 'ruta' cada 'periodo' hasta detenerInstantaneas()
+    // (o la destrucción del motor). El diario debe seguir vivo mientras tanto.
+    bool instantaneasCada(chrono::milliseconds periodo, const string& ruta) {
+        if (instantaneas.joinable()) return false;
+        pararInstantaneas = false;
+        instantaneas = thread([this, periodo, ruta]() {
+            unique_lock<mutex> lock(mtxInstantaneas);
+            while (!cvInstantaneas.wait_for(lock, periodo, [this]() { return pararInstantaneas; })) {
+                lock.unlock();
+                try {
+                    tomarInstantanea(ruta);
+                    numInstantaneas.fetch_add(1, memory_order_relaxed);
+                } catch (const exception& error) {
+                    cerr << "Error: " << error.what() << endl;
+                }
+                lock.lock();
+            }
+        });
+        return true;
+    }
+
+    size_t instantaneasTomadas() const { return numInstantaneas.load(); }
+
+    void detenerInstantaneas() {
+        if (!instantaneas.joinable()) return;
+        {
+            lock_guard<mutex> lock(mtxInstantaneas);
+            pararInstantaneas = true;
+        }
+        cvInstantaneas.notify_all();
+        instantaneas.join();
+    }
+
+    // Arranque: carga la instantánea (si existe) y aplica la cola del diario
+    // (si existe) con 'hilos' hilos. Las altas de cuenta se aplican primero;
+    // después cada hilo aplica, en el orden del diario, los registros de las
+    // cuentas cuyo id cae en su partición (una transferencia toca dos
+    // particiones). Si el diario termina en un registro cortado, se recorta
+    // para que lo que se agregue después quede bien. Se llama con el motor
+    // vacío, antes de operar y sin diario configurado.
+    EstadisticasRecuperacion recuperar(const string& rutaInstantanea, const string& rutaDiario, unsigned hilos) {
+        EstadisticasRecuperacion stats;
+        hilos = max(1u, hilos);
+        PosicionDiario desde;
+        uint64_t maxId = 0;
+
+        auto inicio = chrono::steady_clock::now();
+        int fd = ::open(rutaInstantanea.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            string contenido;
+            char bloque[1 << 16];
+            ssize_t leidos;
+            while ((leidos = ::read(fd, bloque, sizeof(bloque))) != 0) {
+                if (leidos < 0) {
+                    if (errno == EINTR) continue;
+                    ::close(fd);
+                    throw runtime_error("No se pudo leer " + rutaInstantanea + ": " + strerror(errno));
+                }
+                contenido.append(bloque, leidos);
+            }
+            ::close(fd);
+
+            const size_t minimo = 3 * sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+            uint32_t crc;
+            if (contenido.size() < minimo) throw runtime_error("Instantánea corrupta");
+            memcpy(&crc, contenido.data() + contenido.size() - sizeof(crc), sizeof(crc));
+            if (crc != crc32(0, contenido.data(), contenido.size() - sizeof(crc))) {
+                throw runtime_error("Instantánea corrupta");
+            }
+
+            LectorBinario lector(contenido.data(), contenido.size() - sizeof(crc));
+            if (lector.numero<uint64_t>() != MAGIA_INSTANTANEA) throw runtime_error("Instantánea corrupta");
+            desde.secuencia = lector.numero<uint64_t>();
+            desde.bytes = lector.numero<uint64_t>();
+            uint64_t numCuentas;
+            memcpy(&numCuentas, contenido.data() + contenido.size() - sizeof(crc) - sizeof(numCuentas),
+                   sizeof(numCuentas));
+
+            for (uint64_t i = 0; i < numCuentas; ++i) {
+                auto c = make_unique<Cuenta>();
+                c->id = lector.numero<uint64_t>();
+                c->secuencia = lector.numero<uint64_t>();
+                c->saldo = lector.numero<int64_t>();
+                c->activa = lector.numero<uint8_t>() != 0;
+                c->datos.nombre = lector.texto();
+                c->datos.email = lector.texto();
+                c->datos.telefono = lector.texto();
+                c->hashPassword = lector.texto();
+                c->datos.documentoId = lector.texto();
+                c->numeroCuenta = lector.texto();
+                uint32_t numTarjetas = lector.numero<uint32_t>();
+                for (uint32_t t = 0; t < numTarjetas; ++t) {
+                    Tarjeta tarjeta;
+                    tarjeta.tipo = static_cast<TipoTarjeta>(lector.numero<uint8_t>());
+                    tarjeta.activa = lector.numero<uint8_t>() != 0;
+                    tarjeta.limite = lector.numero<int64_t>();
+                    tarjeta.saldoCredito = lector.numero<int64_t>();
+                    tarjeta.numero = lector.texto();
+                    tarjeta.hashCvv = lector.texto();
+                    c->tarjetas.push_back(tarjeta);
+                }
+                maxId = max(maxId, c->id);
+                publicar(std::move(c));
+            }
+            stats.cuentasInstantanea = numCuentas;
+        }
+        stats.secuenciaFinal = desde.secuencia;
+        auto finInstantanea = chrono::steady_clock::now();
+        stats.segundosInstantanea = chrono::duration<double>(finInstantanea - inicio).count();
+
+        fd = ::open(rutaDiario.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            if (desde.bytes > 0) throw runtime_error("Falta el diario " + rutaDiario);
+        } else {
+            struct stat info;
+            ::fstat(fd, &info);
+            uint64_t tamano = static_cast<uint64_t>(info.st_size);
+            if (tamano < desde.bytes) {
+                ::close(fd);
+                throw runtime_error("El diario es más corto que la instantánea");
+            }
+
+            const char* mapa = nullptr;
+            if (tamano > desde.bytes) {
+                void* p = ::mmap(nullptr, tamano, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    ::close(fd);
+                    throw runtime_error("No se pudo mapear el diario: " + string(strerror(errno)));
+                }
+                mapa = static_cast<const char*>(p);
+            }
+
+            // Registros válidos de la cola; se detiene en el primero cortado
+            vector<uint64_t> posiciones;
+            uint64_t pos = desde.bytes;
+            while (tamano - pos >= sizeof(CabeceraRegistro)) {
+                CabeceraRegistro cabecera;
+                memcpy(&cabecera, mapa + pos, sizeof(cabecera));
+                if (tamano - pos - sizeof(cabecera) < cabecera.largoDatos) break;
+                uint32_t crc = crc32(0, mapa + pos + 4, sizeof(cabecera) - 4 + cabecera.largoDatos);
+                if (crc != cabecera.crc) break;
+                posiciones.push_back(pos);
+                pos += sizeof(cabecera) + cabecera.largoDatos;
+            }
+            stats.registrosLeidos = posiciones.size();
+            stats.secuenciaFinal = desde.secuencia + posiciones.size();
+            stats.bytesDescartados = tamano - pos;
+
+            auto leer = [&](size_t i, CabeceraRegistro& cabecera) {
+                memcpy(&cabecera, mapa + posiciones[i], sizeof(cabecera));
+                return string_view(mapa + posiciones[i] + sizeof(cabecera), cabecera.largoDatos);
+            };
+
+            // Altas en orden y reparto del resto por partición
+            vector<vector<uint32_t>> particiones(hilos);
+            for (size_t i = 0; i < posiciones.size(); ++i) {
+                CabeceraRegistro cabecera;
+                string_view datos = leer(i, cabecera);
+                if (cabecera.tipo == REG_ALTA_CUENTA) {
+                    if (buscar(cabecera.cuenta)) continue;
+                    vector<string> campos = camposRegistro(datos);
+                    campos.resize(6);
+                    auto c = make_unique<Cuenta>();
+                    c->id = cabecera.cuenta;
+                    c->datos = {campos[0], campos[1], campos[2], "", campos[4]};
+                    c->hashPassword = campos[3];
+                    c->numeroCuenta = campos[5];
+                    c->saldo = cabecera.monto;
+                    c->secuencia = desde.secuencia + i + 1;
+                    maxId = max(maxId, c->id);
+                    publicar(std::move(c));
+                    stats.registrosAplicados++;
+                    continue;
+                }
+                particiones[cabecera.cuenta % hilos].push_back(static_cast<uint32_t>(i));
+                if (cabecera.tipo == REG_TRANSFERENCIA && cabecera.otra % hilos != cabecera.cuenta % hilos) {
+                    particiones[cabecera.otra % hilos].push_back(static_cast<uint32_t>(i));
+                }
+            }
+
+            atomic<size_t> aplicados(0);
+            atomic<bool> huerfanos(false);
+            auto aplicarParticion = [&](unsigned h) {
+                size_t propios = 0;
+                for (uint32_t i : particiones[h]) {
+                    CabeceraRegistro cabecera;
+                    string_view datos = leer(i, cabecera);
+                    uint64_t secuencia = desde.secuencia + i + 1;
+                    for (int lado = 0; lado < 2; ++lado) {
+                        uint64_t id = lado == 0 ? cabecera.cuenta : cabecera.otra;
+                        if (lado == 1 && cabecera.tipo != REG_TRANSFERENCIA) break;
+                        if (id % hilos != h) continue;
+                        Cuenta* c = buscar(id);
+                        if (!c) {
+                            huerfanos = true;
+                            continue;
+                        }
+                        propios += aplicar(cabecera, datos, secuencia, *c, lado == 1);
+                    }
+                }
+                aplicados += propios;
+            };
+            vector<thread> trabajadores;
+            for (unsigned h = 1; h < hilos; ++h) trabajadores.emplace_back(aplicarParticion, h);
+            aplicarParticion(0);
+            for (thread& t : trabajadores) t.join();
+            stats.registrosAplicados += aplicados.load();
+
+            if (mapa) ::munmap(const_cast<char*>(mapa), tamano);
+            if (stats.bytesDescartados > 0 && ::ftruncate(fd, static_cast<off_t>(pos)) != 0) {
+                ::close(fd);
+                throw runtime_error("No se pudo recortar el diario: " + string(strerror(errno)));
+            }
+            ::close(fd);
+            if (huerfanos) throw runtime_error("El diario tiene registros de cuentas inexistentes");
+        }
+        stats.segundosDiario = chrono::duration<double>(chrono::steady_clock::now() - finInstantanea).count();
+
+        siguienteCuenta = maxId + 1;
+        siguienteTransaccion = stats.secuenciaFinal + 1;
+        return stats;
+    }
+
+    // Suma de todos los saldos. Toma las cuentas de una en una, así que solo
+    // es exacta cuando no hay operaciones en curso.
+    int64_t saldoTotal() const {
+        int64_t total = 0;
+        vector<Cuenta*> lista;
+        for (const FragmentoCuentas& fragmento : porId) {
+            // Como en tomarInstantanea(), el fragmento se suelta antes de
+            // tomar las cuentas: registrarUsuario() toma el fragmento con el
+            // lock de la cuenta nueva tomado
+            lista.clear();
+            {
+                shared_lock<shared_mutex> lockFragmento(fragmento.mtx);
+                for (const auto& par : fragmento.cuentas) lista.push_back(par.second.get());
+            }
+            for (Cuenta* c : lista) {
+                lock_guard<mutex> lock(c->mtx);
+                total += c->saldo;
+            }
+        }
+        return total;
+    }
+};
+
+// Transferencias por segundo con 1, 2, 4, ... hilos: sobre muchas cuentas
+// (casi sin conflictos) y sobre unas pocas cuentas muy usadas
+void benchmark() {
+    const size_t operaciones = 2000000;
+    unsigned maxHilos = max(8u, thread::hardware_concurrency());
+
+    printf("%-8s %6s %14s %10s\n", "cuentas", "hilos", "transf/s", "rechazos");
+    for (size_t numCuentas : {100000, 16}) {
+        MotorCuentas motor;
+        vector<uint64_t> ids;
+        for (size_t i = 0; i < numCuentas; ++i) {
+            ids.push_back(motor.registrarUsuario({"Usuario " + to_string(i), "usuario" + to_string(i) + "@correo.com",
+                                                  "+52-555-0000", "123456", "CURP" + to_string(i)}));
+        }
+        const int64_t totalInicial = motor.saldoTotal();
+
+        for (unsigned hilos = 1; hilos <= maxHilos; hilos *= 2) {
+            atomic<size_t> rechazos(0);
+            auto inicio = chrono::steady_clock::now();
+            vector<thread> trabajadores;
+            for (unsigned h = 0; h < hilos; ++h) {
+                trabajadores.emplace_back([&, h]() {
+                    mt19937_64 rng(h + 1);
+                    size_t propios = 0;
+                    for (size_t i = 0; i < operaciones / hilos; ++i) {
+                        size_t origen = rng() % ids.size();
+                        size_t destino = rng() % ids.size();
+                        if (origen == destino) destino = (destino + 1) % ids.size();
+                        int64_t monto = 100 + static_cast<int64_t>(rng() % 1000);
+                        try {
+                            motor.realizarTransferencia(ids[origen], ids[destino], monto);
+                        } catch (const exception&) {
+                            propios++;
+                        }
+                    }
+                    rechazos += propios;
+                });
+            }
+            for (thread& t : trabajadores) t.join();
+            double seg = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+            size_t total = operaciones / hilos * hilos;
+
+            printf("%-8zu %6u %14.0f %10zu\n", numCuentas, hilos, total / seg, rechazos.load());
+            if (motor.saldoTotal() != totalInicial) printf("  error: el dinero total cambió\n");
+        }
+    }
+}
+
+// Transferencias con diario en 'directorio': latencia de confirmación (hasta
+// que el registro es durable) y transacciones por segundo para varias
+// ventanas de agrupación. Con un hilo cada transacción paga su propio fdatasync.
+void benchmarkDiario(const string& directorio) {
+    const size_t numCuentas = 10000;
+    const chrono::milliseconds duracion(1000);
+    string ruta = directorio + "/diario_bench_" + to_string(::getpid()) + ".bin";
+
+    printf("%-12s %6s %10s %12s %10s %10s %10s\n", "ventana(us)", "hilos", "trans/s", "regs/fsync",
+           "p50(us)", "p99(us)", "p99.9(us)");
+    struct Caso {
+        unsigned hilos;
+        chrono::microseconds ventana;
+    };
+    const Caso casos[] = {
+        {1, chrono::microseconds(0)},
+        {32, chrono::microseconds(0)},
+        {32, chrono::microseconds(200)},
+        {32, chrono::microseconds(1000)},
+        {32, chrono::microseconds(5000)},
+        {128, chrono::microseconds(1000)},
+    };
+    for (const Caso& caso : casos) {
+        ::unlink(ruta.c_str());
+        MotorCuentas motor;
+        vector<uint64_t> ids;
+        for (size_t i = 0; i < numCuentas; ++i) {
+            ids.push_back(motor.registrarUsuario({"Usuario", "usuario" + to_string(i) + "@correo.com",
+                                                  "+52-555-0000", "123456", "CURP"}));
+        }
+
+        ConfigDiario config;
+        config.ventana = caso.ventana;
+        vector<vector<double>> latencias(caso.hilos);
+        size_t lotes;
+        double seg;
+        {
+            DiarioTransacciones diario(ruta, config);
+            motor.setDiario(&diario);
+
+            atomic<bool> parar(false);
+            auto inicio = chrono::steady_clock::now();
+            vector<thread> trabajadores;
+            for (unsigned h = 0; h < caso.hilos; ++h) {
+                trabajadores.emplace_back([&, h]() {
+                    mt19937_64 rng(h + 1);
+                    while (!parar.load(memory_order_relaxed)) {
+                        size_t origen = rng() % ids.size();
+                        size_t destino = (origen + 1 + rng() % (ids.size() - 1)) % ids.size();
+                        auto t0 = chrono::steady_clock::now();
+                        try {
+                            motor.realizarTransferencia(ids[origen], ids[destino], 100);
+                        } catch (const exception&) {
+                            continue;
+                        }
+                        latencias[h].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+                    }
+                });
+            }
+            this_thread::sleep_for(duracion);
+            parar = true;
+            for (thread& t : trabajadores) t.join();
+            seg = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+            lotes = diario.lotes();
+        }
+
+        vector<double> todas;
+        for (auto& propias : latencias) todas.insert(todas.end(), propias.begin(), propias.end());
+        sort(todas.begin(), todas.end());
+        auto percentil = [&](double p) { return todas.empty() ? 0.0 : todas[min(todas.size() - 1, static_cast<size_t>(p * todas.size()))]; };
+        printf("%-12lld %6u %10.0f %12.1f %10.1f %10.1f %10.1f\n", static_cast<long long>(caso.ventana.count()),
+               caso.hilos, todas.size() / seg, static_cast<double>(todas.size()) / max<size_t>(1, lotes),
+               percentil(0.50), percentil(0.99), percentil(0.999));
+    }
+    ::unlink(ruta.c_str());
+}
+
+// Diario artificial para medir el arranque: altas de 'numCuentas' cuentas
+// (si no es 0) y luego 'transferencias' transferencias al azar entre ellas
+void generarDiario(const string& ruta, size_t numCuentas, size_t cuentasExistentes, size_t transferencias,
+                   unsigned semilla) {
+    int fd = ::open(ruta.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) throw runtime_error("No se pudo abrir " + ruta + ": " + strerror(errno));
+
+    string buffer;
+    auto agregar = [&](TipoRegistro tipo, uint64_t cuenta, uint64_t otra, int64_t monto, const string& datos) {
+        CabeceraRegistro cabecera = {};
+        cabecera.tipo = tipo;
+        cabecera.cuenta = cuenta;
+        cabecera.otra = otra;
+        cabecera.monto = monto;
+        sellarRegistro(cabecera, datos);
+        buffer.append(reinterpret_cast<const char*>(&cabecera), sizeof(cabecera));
+        buffer += datos;
+        if (buffer.size() >= (1 << 20)) {
+            escribirTodo(fd, buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    // Todas las cuentas comparten sal: solo importa el tamaño de los registros
+    const string hashPassword = hashSalado("123456", "00112233445566778899aabbccddeeff");
+    const string hashCvv = hashSalado("123", "00112233445566778899aabbccddeeff");
+    for (size_t i = 1; i <= numCuentas; ++i) {
+        string email = "usuario" + to_string(i) + "@correo.com";
+        agregar(REG_ALTA_CUENTA, i, 0, 100000,
+                string("Usuario") + '\0' + email + '\0' + "+52-555-0000" + '\0' + hashPassword + '\0' + "CURP" +
+                    '\0' + to_string(4000000000ull + i));
+        agregar(REG_ALTA_TARJETA, i, DEBITO, 0, "4000111122223333" + string(1, '\0') + hashCvv);
+    }
+    size_t cuentas = numCuentas + cuentasExistentes;
+    mt19937_64 rng(semilla);
+    const string concepto = "Transferencia";
+    for (size_t i = 0; i < transferencias; ++i) {
+        uint64_t origen = 1 + rng() % cuentas;
+        uint64_t destino = 1 + (origen + rng() % (cuentas - 1)) % cuentas;
+        agregar(REG_TRANSFERENCIA, origen, destino, 1 + static_cast<int64_t>(rng() % 1000), concepto);
+    }
+    escribirTodo(fd, buffer.data(), buffer.size());
+    ::close(fd);
+}
+
+// Instantáneas tomadas mientras otros hilos registran cuentas y depositan en
+// ellas: al recuperar desde cada una deben aparecer todas las cuentas con
+// sus saldos
+// Un diario sobre /dev/full: la primera escritura falla con ENOSPC. Después
+// el motor debe rechazar los cambios sin aplicarlos.
+void probarDiarioFallido() {
+    if (::access("/dev/full", W_OK) != 0) {
+        printf("diario fallido: omitido (no hay /dev/full)\n");
+        return;
+    }
+    MotorCuentas motor;
+    uint64_t ana = motor.registrarUsuario({"Ana", "ana@correo.com", "+52-555-0001", "123456", "CURP1"});
+    uint64_t beto = motor.registrarUsuario({"Beto", "beto@correo.com", "+52-555-0002", "654321", "CURP2"});
+    DiarioTransacciones diario("/dev/full");
+    motor.setDiario(&diario);
+
+    bool correcto = true;
+    auto lanza = [](auto&& operacion) {
+        try {
+            operacion();
+        } catch (const runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    // El primer depósito ya está en memoria cuando el diario falla
+    correcto &= lanza([&]() { motor.realizarDeposito(ana, centavos(10)); });
+    int64_t saldoAna = motor.consultarSaldo(ana);
+    int64_t saldoBeto = motor.consultarSaldo(beto);
+    size_t tarjetasAna = motor.tarjetas(ana).size();
+
+    correcto &= lanza([&]() { motor.realizarDeposito(ana, centavos(10)); });
+    correcto &= lanza([&]() { motor.realizarRetiro(ana, centavos(10)); });
+    correcto &= lanza([&]() { motor.realizarTransferencia(ana, beto, centavos(10)); });
+    correcto &= lanza([&]() { motor.solicitarTarjetaCredito(ana); });
+    correcto &= lanza([&]() { motor.registrarUsuario({"Eva", "eva@correo.com", "+52-555-0003", "1", "CURP3"}); });
+    correcto &= motor.consultarSaldo(ana) == saldoAna && motor.consultarSaldo(beto) == saldoBeto &&
+                motor.tarjetas(ana).size() == tarjetasAna && motor.numCuentas() == 2;
+    motor.setDiario(nullptr);
+    printf("diario fallido: %s\n", correcto ? "ok, el motor queda de solo lectura" : "ERROR: se aplicaron cambios");
+}
+
+void probarInstantaneaConAltas(const string& directorio) {
+    string base = directorio + "/altas_prueba_" + to_string(::getpid());
+    string rutaDiario = base + ".diario";
+    string rutaInstantanea = base + ".instantanea";
+    const unsigned hilos = 4;
+    const size_t altasPorHilo = 300;
+    size_t fallas = 0, instantaneas = 0;
+
+    for (int ronda = 0; ronda < 5; ++ronda) {
+        ::unlink(rutaDiario.c_str());
+        ::unlink(rutaInstantanea.c_str());
+        vector<int64_t> esperado;
+        {
+            MotorCuentas motor;
+            DiarioTransacciones diario(rutaDiario);
+            motor.setDiario(&diario);
+
+            atomic<unsigned> terminados(0);
+            vector<thread> trabajadores;
+            for (unsigned h = 0; h < hilos; ++h) {
+                trabajadores.emplace_back([&, h]() {
+                    for (size_t i = 0; i < altasPorHilo; ++i) {
+                        string email = "r" + to_string(ronda) + "_h" + to_string(h) + "_" + to_string(i) + "@correo.com";
+                        uint64_t id = motor.registrarUsuario({"Usuario", email, "+52-555-0000", "123456", "CURP"});
+                        motor.realizarDeposito(id, 100 + static_cast<int64_t>(i));
+                    }
+                    terminados++;
+                });
+            }
+            // La última instantánea se toma con las altas todavía en curso
+            while (terminados.load() < hilos) {
+                motor.tomarInstantanea(rutaInstantanea);
+                instantaneas++;
+            }
+            for (thread& t : trabajadores) t.join();
+            motor.setDiario(nullptr);
+            for (uint64_t id = 1; id <= motor.numCuentas(); ++id) esperado.push_back(motor.consultarSaldo(id));
+        }
+
+        MotorCuentas recuperado;
+        try {
+            recuperado.recuperar(rutaInstantanea, rutaDiario, 3);
+            bool igual = recuperado.numCuentas() == esperado.size();
+            for (uint64_t id = 1; igual && id <= esperado.size(); ++id) {
+                igual = recuperado.consultarSaldo(id) == esperado[id - 1];
+            }
+            fallas += !igual;
+        } catch (const exception& error) {
+            printf("  error al recuperar: %s\n", error.what());
+            fallas++;
+        }
+    }
+    printf("instantaneas con altas concurrentes: %zu instantaneas, %s\n", instantaneas,
+           fallas == 0 ? "ok" : "ERROR: faltan cuentas o saldos");
+    ::unlink(rutaDiario.c_str());
+    ::unlink(rutaInstantanea.c_str());
+}
+
+// Tiempo de arranque contra el tamaño del diario: reproducir todo el diario
+// con 1 hilo y con varios, contra cargar una instantánea tomada al 90% y
+// reproducir solo el resto. Los tres arranques deben dar los mismos saldos.
+// instantaneasCada() con tráfico: altas, depósitos y transferencias mientras
+// el hilo de instantáneas corre; después se detiene, se recupera y se
+// compara. También revisa que ni el diario ni la instantánea lleven la
+// contraseña en claro.
+void probarInstantaneasPeriodicas(const string& directorio) {
+    string base = directorio + "/periodicas_prueba_" + to_string(::getpid());
+    string rutaDiario = base + ".diario";
+    string rutaInstantanea = base + ".instantanea";
+    const string password = "clave-secreta";
+    const unsigned hilos = 4;
+    const size_t operacionesPorHilo = 2000;
+    ::unlink(rutaDiario.c_str());
+    ::unlink(rutaInstantanea.c_str());
+
+    vector<int64_t> esperado;
+    size_t tomadas = 0;
+    bool correcto = true;
+    {
+        MotorCuentas motor;
+        DiarioTransacciones diario(rutaDiario);
+        motor.setDiario(&diario);
+        correcto &= motor.instantaneasCada(chrono::milliseconds(2), rutaInstantanea);
+        correcto &= !motor.instantaneasCada(chrono::milliseconds(2), rutaInstantanea);   // ya corre
+
+        vector<thread> trabajadores;
+        for (unsigned h = 0; h < hilos; ++h) {
+            trabajadores.emplace_back([&, h]() {
+                mt19937_64 rng(h + 1);
+                vector<uint64_t> propias;
+                for (size_t i = 0; i < operacionesPorHilo; ++i) {
+                    if (propias.empty() || rng() % 8 == 0) {
+                        string email = "p_h" + to_string(h) + "_" + to_string(i) + "@correo.com";
+                        propias.push_back(motor.registrarUsuario({"Usuario", email, "+52-555-0000", password, "CURP"}));
+                    } else if (rng() % 2 == 0) {
+                        motor.realizarDeposito(propias[rng() % propias.size()], 1 + static_cast<int64_t>(rng() % 1000));
+                    } else {
+                        // Hacia cualquier cuenta ya creada, de este hilo o de otro
+                        uint64_t destino = 1 + rng() % motor.numCuentas();
+                        uint64_t origen = propias[rng() % propias.size()];
+                        if (destino != origen) {
+                            try {
+                                motor.realizarTransferencia(origen, destino, 1 + static_cast<int64_t>(rng() % 500));
+                            } catch (const runtime_error&) {
+                                // saldo insuficiente
+                            }
+                        }
+                    }
+                }
+            });
+        }
+        for (thread& t : trabajadores) t.join();
+        // Al menos una instantánea después del tráfico, por si las operaciones
+        // terminaron antes del primer periodo
+        size_t antes = motor.instantaneasTomadas();
+        for (int i = 0; i < 2000 && motor.instantaneasTomadas() < antes + 1; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        motor.detenerInstantaneas();
+        motor.detenerInstantaneas();
+        tomadas = motor.instantaneasTomadas();
+        correcto &= tomadas > antes;
+
+        // Se puede volver a iniciar después de detenerlo
+        correcto &= motor.instantaneasCada(chrono::milliseconds(1), rutaInstantanea);
+        motor.detenerInstantaneas();
+
+        motor.setDiario(nullptr);
+        for (uint64_t id = 1; id <= motor.numCuentas(); ++id) esperado.push_back(motor.consultarSaldo(id));
+    }
+
+    auto contiene = [](const string& ruta, const string& texto) {
+        string contenido;
+        int fd = ::open(ruta.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        char bloque[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, bloque, sizeof(bloque))) > 0) contenido.append(bloque, n);
+        ::close(fd);
+        return contenido.find(texto) != string::npos;
+    };
+    bool enClaro = contiene(rutaDiario, password) || contiene(rutaInstantanea, password);
+
+    try {
+        MotorCuentas recuperado;
+        recuperado.recuperar(rutaInstantanea, rutaDiario, 3);
+        correcto &= recuperado.numCuentas() == esperado.size();
+        for (uint64_t id = 1; correcto && id <= esperado.size(); ++id) {
+            correcto = recuperado.consultarSaldo(id) == esperado[id - 1];
+        }
+        correcto &= recuperado.iniciarSesion("p_h0_0@correo.com", password) != 0;
+    } catch (const exception& error) {
+        printf("  error al recuperar: %s\n", error.what());
+        correcto = false;
+    }
+    printf("instantaneas periodicas con trafico: %zu instantaneas, %s%s\n", tomadas,
+           correcto ? "ok" : "ERROR: la recuperacion no coincide",
+           enClaro ? ", ERROR: contrasena en claro en disco" : "");
+    ::unlink(rutaDiario.c_str());
+    ::unlink(rutaInstantanea.c_str());
+}
+
+void benchmarkArranque(const string& directorio) {
+    const size_t numCuentas = 50000;
+    unsigned hilos = max(4u, thread::hardware_concurrency());
+    string base = directorio + "/arranque_bench_" + to_string(::getpid());
+    string rutaDiario = base + ".diario";
+    string rutaInstantanea = base + ".instantanea";
+
+    auto huella = [&](MotorCuentas& motor) {
+        uint64_t h = 0;
+        for (uint64_t id = 1; id <= numCuentas; ++id) h = h * 1000003 + static_cast<uint64_t>(motor.consultarSaldo(id));
+        return h;
+    };
+
+    printf("%12s %8s %16s %16s %22s\n", "registros", "MB", "completo 1 hilo", "completo N hilos",
+           "instantanea + 10%");
+    for (size_t transferencias : {250000, 1000000, 4000000}) {
+        ::unlink(rutaDiario.c_str());
+        ::unlink(rutaInstantanea.c_str());
+        size_t cola = transferencias / 10;
+        generarDiario(rutaDiario, numCuentas, 0, transferencias - cola, 1);
+
+        // Instantánea al 90%
+        {
+            MotorCuentas motor;
+            EstadisticasRecuperacion stats = motor.recuperar(rutaInstantanea, rutaDiario, hilos);
+            DiarioTransacciones diario(rutaDiario, ConfigDiario(), stats.secuenciaFinal);
+            motor.setDiario(&diario);
+            motor.tomarInstantanea(rutaInstantanea);
+            motor.setDiario(nullptr);
+        }
+        generarDiario(rutaDiario, 0, numCuentas, cola, 2);
+
+        struct stat info;
+        ::stat(rutaDiario.c_str(), &info);
+        double segundos[3];
+        uint64_t huellas[3];
+        for (int modo = 0; modo < 3; ++modo) {
+            MotorCuentas motor;
+            auto inicio = chrono::steady_clock::now();
+            motor.recuperar(modo == 2 ? rutaInstantanea : base + ".no_existe", rutaDiario, modo == 0 ? 1 : hilos);
+            segundos[modo] = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+            huellas[modo] = huella(motor);
+        }
+        printf("%12zu %8.1f %14.3f s %14.3f s %20.3f s\n", transferencias + 2 * numCuentas, info.st_size / 1e6,
+               segundos[0], segundos[1], segundos[2]);
+        if (huellas[0] != huellas[1] || huellas[0] != huellas[2]) printf("  error: los saldos no coinciden\n");
+    }
+    printf("(N = %u hilos)\n", hilos);
+    ::unlink(rutaDiario.c_str());
+    ::unlink(rutaInstantanea.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        benchmark();
+        cout << endl;
+        // El diario se mide en un directorio en disco (no en tmpfs, donde fdatasync no cuesta)
+        benchmarkDiario(argc > 2 ? argv[2] : ".");
+        cout << endl;
+        probarDiarioFallido();
+        probarInstantaneaConAltas(argc > 2 ? argv[2] : ".");
+        probarInstantaneasPeriodicas(argc > 2 ? argv[2] : ".");
+        benchmarkArranque(argc > 2 ? argv[2] : ".");
+        return 0;
+    }
+
+    // El mismo recorrido que ejecutarDemo() del original
+    MotorCuentas banco;
+    banco.setNotificador([](const char* canal, const string& destino, const string& mensaje) {
+        cout << (strcmp(canal, "sms") == 0 ? "SMS a " : "Email a ") << destino << ": " << mensaje << endl;
+    });
+    auto mostrarPesos = [](const char* texto, int64_t monto) {
+        printf("%s: $%lld.%02lld\n", texto, static_cast<long long>(monto / 100), static_cast<long long>(monto % 100));
+    };
+
+    try {
+        Tarjeta debito;
+        banco.registrarUsuario({"Juan Pérez", "juan@email.com", "+52-555-1234", "123456", "CURP123456"}, &debito);
+        banco.registrarUsuario({"María García", "maria@email.com", "+52-555-5678", "654321", "CURP654321"});
+
+        uint64_t juan = banco.iniciarSesion("juan@email.com", "123456");
+        mostrarPesos("Saldo actual", banco.consultarSaldo(juan));
+        banco.realizarDeposito(juan, centavos(500), "Depósito inicial adicional");
+        Tarjeta credito = banco.solicitarTarjetaCredito(juan);
+
+        banco.pagarConTarjeta(juan, debito.numero, centavos(100), "Supermercado XYZ", debito.cvv);
+        banco.pagarConTarjeta(juan, credito.numero, centavos(250), "Librería ABC", credito.cvv);
+        banco.realizarTransferencia(juan, "maria@email.com", centavos(200), "Pago prestamo");
+
+        cout << endl << "Historial:" << endl;
+        for (const Transaccion& t : banco.verHistorial(juan, 5)) {
+            printf("  %-22s $%9.2f  saldo $%9.2f  %s\n", nombreTransaccion(t.tipo), t.monto / 100.0,
+                   t.saldoNuevo / 100.0, t.concepto.c_str());
+        }
+
+        banco.realizarRetiro(juan, centavos(100000));
+    } catch (const exception& error) {
+        cout << "Error: " << error.what() << endl;
+    }
+
+    return 0;
+}
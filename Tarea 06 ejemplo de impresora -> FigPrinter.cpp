@@ -1,14 +1,447 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <list>
+#include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <unistd.h>
+#endif
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+// Pool de hilos mínimo: run(n, tarea) ejecuta tarea(0..n-1) repartiendo los
+// índices entre los hilos (el que llama también trabaja) y espera a que todos
+// terminen.
+class RenderPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* task = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextIndex{0};
+    size_t busyWorkers = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+    
+    void drain() {
+        for (size_t i = nextIndex.fetch_add(1); i < taskCount; i = nextIndex.fetch_add(1)) {
+            (*task)(i);
+        }
+    }
+    
+    void workerLoop() {
+        unsigned long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mtx);
+            if (--busyWorkers == 0) done.notify_one();
+        }
+    }
+    
+public:
+    explicit RenderPool(unsigned threads) {
+        // El hilo que llama a run() cuenta como uno de los hilos
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(&RenderPool::workerLoop, this);
+        }
+    }
+    
+    ~RenderPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+    
+    void run(size_t count, const std::function<void(size_t)>& fn) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            task = &fn;
+            taskCount = count;
+            nextIndex.store(0);
+            busyWorkers = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait(lock, [&]() { return busyWorkers == 0; });
+    }
+};
+
+// Fuente FIGlet (.flf) de carga perezosa. open() mapea el archivo en memoria
+// (mmap) y solo lee el encabezado. El índice de glifos se arma con un único
+// recorrido del archivo que avanza solo lo necesario cada vez que se pide un
+// carácter todavía no visto, y decode() convierte las filas de un glifo.
+class FigletFont {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::string fileContents;
+#endif
+    char hardblank = '$';
+    int height = 0;
+    
+    // Estado del recorrido del índice
+    size_t scanPos = 0;
+    int requiredIndex = 0; // siguiente carácter obligatorio (ASCII 32..126 y 7 alemanes)
+    bool scanDone = false;
+    long glyphOffset[256];
+    
+    static int requiredCode(int index) {
+        static const int GERMAN[] = {196, 214, 220, 228, 246, 252, 223};
+        return index < 95 ? 32 + index : GERMAN[index - 95];
+    }
+    static const int REQUIRED_COUNT = 95 + 7;
+    
+    size_t nextLine(size_t pos) const {
+        const void* newline = std::memchr(data + pos, '\n', size - pos);
+        return newline ? static_cast<const char*>(newline) - data + 1 : size;
+    }
+    
+    // Salta las filas de un glifo; false si el archivo termina antes
+    bool skipGlyph(size_t& pos) const {
+        for (int line = 0; line < height; line++) {
+            if (pos >= size) return false;
+            pos = nextLine(pos);
+        }
+        return true;
+    }
+    
+    // Avanza el recorrido un glifo y registra su posición
+    bool scanNext() {
+        if (scanDone) return false;
+        
+        long code;
+        if (requiredIndex < REQUIRED_COUNT) {
+            code = requiredCode(requiredIndex++);
+        } else {
+            // Glifos con código explícito: "<código> [comentario]" y luego las filas
+            if (scanPos >= size) {
+                scanDone = true;
+                return false;
+            }
+            size_t end = nextLine(scanPos);
+            char line[64];
+            size_t length = std::min(end - scanPos, sizeof(line) - 1);
+            std::memcpy(line, data + scanPos, length);
+            line[length] = '\0';
+            char* parsedEnd;
+            code = std::strtol(line, &parsedEnd, 0);
+            if (parsedEnd == line) {
+                scanDone = true;
+                return false;
+            }
+            scanPos = end;
+        }
+        
+        size_t glyphStart = scanPos;
+        if (!skipGlyph(scanPos)) {
+            scanDone = true;
+            return false;
+        }
+        if (code >= 0 && code < 256 && glyphOffset[code] < 0) {
+            glyphOffset[code] = static_cast<long>(glyphStart);
+        }
+        return true;
+    }
+    
+    void unmap() {
+#ifndef _WIN32
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+    
+public:
+    FigletFont() {
+        for (long& offset : glyphOffset) offset = -1;
+    }
+    
+    ~FigletFont() {
+        unmap();
+    }
+    
+    FigletFont(const FigletFont&) = delete;
+    FigletFont& operator=(const FigletFont&) = delete;
+    
+    bool open(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        fileContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = fileContents.data();
+        size = fileContents.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = static_cast<const char*>(mapped);
+        size = static_cast<size_t>(info.st_size);
+#endif
+        
+        // Encabezado: flf2a<hardblank> altura base largo_max layout lineas_comentario ...
+        size_t end = nextLine(0);
+        char header[128];
+        size_t length = std::min(end, sizeof(header) - 1);
+        std::memcpy(header, data, length);
+        header[length] = '\0';
+        
+        int baseline, maxLength, oldLayout, commentLines;
+        if (std::strncmp(header, "flf2", 4) != 0 || length < 6 ||
+            std::sscanf(header + 6, "%d %d %d %d %d", &height, &baseline, &maxLength,
+                        &oldLayout, &commentLines) != 5 || height <= 0) {
+            unmap();
+            return false;
+        }
+        hardblank = header[5];
+        
+        scanPos = end;
+        for (int i = 0; i < commentLines && scanPos < size; i++) scanPos = nextLine(scanPos);
+        return true;
+    }
+    
+    int getHeight() const {
+        return height;
+    }
+    
+    // Filas del glifo, sin las marcas de fin de línea y con el hardblank
+    // cambiado por espacio. false si la fuente no tiene el carácter.
+    bool decode(unsigned char code, std::vector<std::string>& rows) {
+        while (glyphOffset[code] < 0 && scanNext()) {
+        }
+        if (glyphOffset[code] < 0) return false;
+        
+        rows.clear();
+        size_t pos = static_cast<size_t>(glyphOffset[code]);
+        for (int line = 0; line < height; line++) {
+            size_t next = nextLine(pos);
+            size_t end = next;
+            while (end > pos && (data[end - 1] == '\n' || data[end - 1] == '\r')) end--;
+            if (end > pos) {
+                char endmark = data[end - 1];
+                while (end > pos && data[end - 1] == endmark) end--;
+            }
+            std::string row(data + pos, end - pos);
+            std::replace(row.begin(), row.end(), hardblank, ' ');
+            rows.push_back(row);
+            pos = next;
+        }
+        return true;
+    }
+};
+
+// Destino de la salida de FigPrinter. Cada llamada a print* hace un solo
+// write() con la salida completa.
+class OutputSink {
+public:
+    virtual void write(const char* data, size_t length) = 0;
+    virtual void flush() {}
+    // true si alguna escritura falló (después de flush() incluye lo que
+    // estaba en buffer)
+    virtual bool failed() const { return false; }
+    virtual ~OutputSink() {}
+};
+
+// Escribe en un std::ostream (por defecto FigPrinter usa std::cout)
+class OstreamSink : public OutputSink {
+private:
+    std::ostream& out;
+    
+public:
+    explicit OstreamSink(std::ostream& stream) : out(stream) {}
+    
+    void write(const char* data, size_t length) override {
+        out.write(data, static_cast<std::streamsize>(length));
+    }
+    
+    void flush() override {
+        out.flush();
+    }
+    
+    bool failed() const override {
+        return out.fail();
+    }
+};
+
+// Acumula la salida en memoria
+class MemorySink : public OutputSink {
+private:
+    std::string buffer;
+    
+public:
+    void write(const char* data, size_t length) override {
+        buffer.append(data, length);
+    }
+    
+    const std::string& str() const { return buffer; }
+    void clear() { buffer.clear(); }
+};
+
+#ifndef _WIN32
+// Escribe directo a un descriptor de archivo, juntando la salida en un
+// buffer propio grande para hacer pocas llamadas al sistema. No cierra el fd.
+// El primer error de write() (EPIPE, ENOSPC...) queda guardado: lo que se
+// escribe después se descarta y failed() lo reporta.
+class FdSink : public OutputSink {
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t used = 0;
+    int error = 0;
+    
+    void writeAll(const char* data, size_t length) {
+        while (length > 0 && error == 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) {
+                if (errno != EINTR) error = errno;
+                continue;
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+    
+public:
+    explicit FdSink(int descriptor, size_t bufferSize = 1 << 20)
+        : fd(descriptor), buffer(std::max<size_t>(bufferSize, 1)) {}
+    
+    ~FdSink() {
+        flush();
+    }
+    
+    void write(const char* data, size_t length) override {
+        if (used + length > buffer.size()) {
+            flush();
+            // Lo que no cabe en el buffer se escribe directamente
+            if (length >= buffer.size()) {
+                writeAll(data, length);
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, data, length);
+        used += length;
+    }
+    
+    void flush() override {
+        if (used > 0) writeAll(buffer.data(), used);
+        used = 0;
+    }
+    
+    bool failed() const override {
+        return error != 0;
+    }
+    
+    // errno del primer write() que falló, o 0
+    int lastError() const {
+        return error;
+    }
+};
+#endif
 
 class FigPrinter {
 private:
+    // Filas por glifo: 7 con la fuente integrada, o la altura de la fuente
+    // FIGlet cargada con loadFont
+    static const int MAX_GLYPH_ROWS = 64;
+    int glyphRows = 7;
+    
     // Mapa de caracteres ASCII art (5x7)
     std::map<char, std::vector<std::string>> charMap;
     
+    // Atlas plano de glifos: todas las filas de todos los glifos en un solo
+    // buffer contiguo, y una tabla de 256 entradas con (offset, largo) de cada
+    // fila. Los caracteres sin glifo apuntan a las filas de '?', así que al
+    // renderizar basta con un acceso indexado por glifo y fila.
+    struct GlyphRow {
+        uint32_t offset;
+        uint32_t length;
+    };
+    std::string rowBuffer;
+    std::vector<GlyphRow> atlas; // 256 * glyphRows entradas
+    
+    // Formato compacto para los glifos de hasta 8 columnas con solo dos
+    // caracteres (primer plano y fondo): un bit por celda, la fila r en los
+    // bits 8r..8r+7. Cada glifo ocupa 16 bytes, así que una fuente entera cabe
+    // en pocas líneas de caché. Los glifos que no cumplen (filas de distinto
+    // largo, más de dos caracteres o caracteres de varios bytes) siguen usando
+    // las filas del atlas.
+    struct PackedGlyph {
+        uint64_t bits;
+        char foreground;
+        char background;
+        uint8_t width;
+        bool packed;
+    };
+    PackedGlyph packedGlyphs[256];
+    bool packingEnabled = true;
+    
+    // Fuente FIGlet externa (opcional) y glifos que aún no se decodifican
+    std::unique_ptr<FigletFont> font;
+    bool glyphPending[256];
+    
+    // EXPAND_MASK[m] tiene el byte i en 0xFF si el bit i de m está encendido
+    struct ExpandTable {
+        uint64_t mask[256];
+        
+        ExpandTable() {
+            for (int m = 0; m < 256; m++) {
+                unsigned char bytes[8];
+                for (int i = 0; i < 8; i++) bytes[i] = (m >> i) & 1 ? 0xFF : 0x00;
+                std::memcpy(&mask[m], bytes, 8);
+            }
+        }
+    };
+    static const ExpandTable& expandTable() {
+        static const ExpandTable table;
+        return table;
+    }
+    
+    // Bytes extra que appendRow puede escribir más allá del final
+    static const size_t ROW_SLACK = 8;
+    
+    friend void benchmarkGlyphLookup();
+    
     void initializeCharMap() {
         // Letra A
         charMap['A'] = {
@@ -132,86 +565,586 @@ private:
         };
     }
     
-public:
-    FigPrinter() {
-        initializeCharMap();
+    // Reconstruye el atlas a partir de charMap. Con una fuente FIGlet cargada,
+    // los caracteres que no están en charMap quedan pendientes y se decodifican
+    // la primera vez que se usan (ver ensureGlyph).
+    void buildAtlas() {
+        rowBuffer.clear();
+        atlas.assign(256 * glyphRows, GlyphRow{0, 0});
+        std::map<char, std::vector<std::string>>::const_iterator unknown = charMap.find('?');
+        
+        for (int c = 0; c < 256; c++) {
+            glyphPending[c] = false;
+            std::map<char, std::vector<std::string>>::const_iterator it = charMap.find(static_cast<char>(c));
+            if (it == charMap.end()) continue;
+            storeGlyphRows(static_cast<unsigned char>(c), it->second);
+        }
+        
+        // Los caracteres sin glifo usan las filas de '?'
+        const unsigned char q = '?';
+        for (int c = 0; c < 256; c++) {
+            if (charMap.find(static_cast<char>(c)) != charMap.end()) continue;
+            if (font) {
+                glyphPending[c] = true;
+                continue;
+            }
+            for (int line = 0; line < glyphRows; line++) {
+                atlas[c * glyphRows + line] = unknown != charMap.end() ? atlas[q * glyphRows + line] : GlyphRow{0, 0};
+            }
+        }
+        
+        for (int c = 0; c < 256; c++) {
+            if (!glyphPending[c]) packedGlyphs[c] = packGlyph(static_cast<unsigned char>(c));
+        }
     }
     
-    void printText(const std::string& text) {
-        if (text.empty()) return;
-        
-        // Convertir a mayúsculas
-        std::string upperText = text;
-        std::transform(upperText.begin(), upperText.end(), upperText.begin(), ::toupper);
+    void storeGlyphRows(unsigned char c, const std::vector<std::string>& rows) {
+        for (int line = 0; line < glyphRows; line++) {
+            const std::string& row = rows[line];
+            atlas[c * glyphRows + line].offset = static_cast<uint32_t>(rowBuffer.size());
+            atlas[c * glyphRows + line].length = static_cast<uint32_t>(row.size());
+            rowBuffer += row;
+        }
+    }
+    
+    // Decodifica un glifo pendiente de la fuente FIGlet; si la fuente no lo
+    // tiene, usa las filas de '?'
+    void resolveGlyph(unsigned char c) {
+        glyphPending[c] = false;
         
-        // Imprimir línea por línea
-        for (int line = 0; line < 7; line++) {
-            for (char c : upperText) {
-                if (charMap.find(c) != charMap.end()) {
-                    std::cout << charMap[c][line];
-                } else {
-                    std::cout << charMap['?'][line];
-                }
+        std::vector<std::string> rows;
+        if (font->decode(c, rows) && rows.size() == static_cast<size_t>(glyphRows)) {
+            charMap[static_cast<char>(c)] = rows;
+            storeGlyphRows(c, rows);
+        } else {
+            const unsigned char q = '?';
+            if (c != q && glyphPending[q]) resolveGlyph(q);
+            for (int line = 0; line < glyphRows; line++) {
+                atlas[c * glyphRows + line] = c != q ? atlas[q * glyphRows + line] : GlyphRow{0, 0};
             }
-            std::cout << std::endl;
         }
+        packedGlyphs[c] = packGlyph(c);
     }
     
-    void printBanner(const std::string& text, char borderChar = '*') {
-        std::string upperText = text;
-        std::transform(upperText.begin(), upperText.end(), upperText.begin(), ::toupper);
+    // Se llama con cada carácter antes de medir o renderizar (siempre desde un
+    // solo hilo); el caso común es un acceso y un salto que no se toma
+    void ensureGlyph(char c) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (glyphPending[uc]) resolveGlyph(uc);
+    }
+    
+    // Intenta empaquetar el glifo del atlas; si no se puede, packed = false
+    PackedGlyph packGlyph(unsigned char c) const {
+        PackedGlyph glyph = {0, ' ', ' ', 0, false};
+        if (!packingEnabled || glyphRows > 8) return glyph;
         
-        // Calcular ancho del banner
-        int width = 0;
-        for (char c : upperText) {
-            if (charMap.find(c) != charMap.end()) {
-                width += charMap[c][0].length();
-            } else {
-                width += charMap['?'][0].length();
+        size_t width = atlas[c * glyphRows].length;
+        if (width > 8) return glyph;
+        
+        // Caracteres usados: a lo sumo dos, y de un solo byte
+        char used[2];
+        int usedCount = 0;
+        for (int line = 0; line < glyphRows; line++) {
+            if (atlas[c * glyphRows + line].length != width) return glyph;
+            const char* row = rowBuffer.data() + atlas[c * glyphRows + line].offset;
+            for (size_t i = 0; i < width; i++) {
+                if (static_cast<unsigned char>(row[i]) >= 0x80) return glyph;
+                if (usedCount > 0 && row[i] == used[0]) continue;
+                if (usedCount > 1 && row[i] == used[1]) continue;
+                if (usedCount == 2) return glyph;
+                used[usedCount++] = row[i];
             }
         }
         
-        // Imprimir borde superior
-        std::cout << std::string(width + 4, borderChar) << std::endl;
+        // El espacio es el fondo si aparece; si no, el primer carácter usado
+        if (usedCount == 2 && used[0] == ' ') std::swap(used[0], used[1]);
+        glyph.foreground = usedCount > 0 ? used[0] : ' ';
+        glyph.background = usedCount > 1 ? used[1] : ' ';
         
-        // Imprimir texto con bordes laterales
-        for (int line = 0; line < 7; line++) {
-            std::cout << borderChar << " ";
-            for (char c : upperText) {
-                if (charMap.find(c) != charMap.end()) {
-                    std::cout << charMap[c][line];
-                } else {
-                    std::cout << charMap['?'][line];
+        for (int line = 0; line < glyphRows; line++) {
+            const char* row = rowBuffer.data() + atlas[c * glyphRows + line].offset;
+            for (size_t i = 0; i < width; i++) {
+                if (row[i] == glyph.foreground && row[i] != glyph.background) {
+                    glyph.bits |= uint64_t(1) << (8 * line + i);
                 }
             }
-            std::cout << " " << borderChar << std::endl;
         }
+        glyph.width = static_cast<uint8_t>(width);
+        glyph.packed = true;
+        return glyph;
+    }
+    
+    const GlyphRow& glyphRow(char c, int line) const {
+        return atlas[static_cast<unsigned char>(c) * glyphRows + line];
+    }
+    
+    int glyphWidth(char c) const {
+        return static_cast<int>(glyphRow(c, 0).length);
+    }
+    
+    // Texto en mayúsculas y buffer de salida, reutilizados entre llamadas
+    std::string upperText;
+    std::string renderBuffer;
+    
+    void prepareText(const std::string& text) {
+        upperText.assign(text);
+        for (char& c : upperText) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            ensureGlyph(c);
+        }
+    }
+    
+    // Bytes que ocupa cada fila del texto (los glifos no miden lo mismo en
+    // todas las filas, así que se suman por separado)
+    void measureRows(const std::string& glyphs, size_t rowBytes[]) const {
+        for (int line = 0; line < glyphRows; line++) rowBytes[line] = 0;
+        for (char c : glyphs) {
+            const PackedGlyph& packed = packedGlyphs[static_cast<unsigned char>(c)];
+            for (int line = 0; line < glyphRows; line++) {
+                rowBytes[line] += packed.packed ? packed.width : glyphRow(c, line).length;
+            }
+        }
+    }
+    
+    // Los glifos empaquetados se expanden de a 8 bytes por fila: la máscara de
+    // la fila elige, byte por byte, entre el carácter de primer plano y el de
+    // fondo. Puede escribir hasta ROW_SLACK bytes después del final.
+    char* appendRow(char* out, const std::string& glyphs, int line) const {
+        const uint64_t ONES = 0x0101010101010101ULL;
+        const uint64_t* expand = expandTable().mask;
+        for (char c : glyphs) {
+            const PackedGlyph& packed = packedGlyphs[static_cast<unsigned char>(c)];
+            if (packed.packed) {
+                uint64_t mask = expand[(packed.bits >> (8 * line)) & 0xFF];
+                uint64_t word = (mask & (ONES * static_cast<unsigned char>(packed.foreground))) |
+                                (~mask & (ONES * static_cast<unsigned char>(packed.background)));
+                std::memcpy(out, &word, 8);
+                out += packed.width;
+            } else {
+                const GlyphRow& row = glyphRow(c, line);
+                std::memcpy(out, rowBuffer.data() + row.offset, row.length);
+                out += row.length;
+            }
+        }
+        return out;
+    }
+    
+    static char* appendFill(char* out, size_t count, char fill) {
+        std::memset(out, fill, count);
+        return out + count;
+    }
+    
+    // Agrega al final de 'output' una banda de 7 filas con 'padding' espacios
+    // a la izquierda. Solo lee el atlas, así que es seguro llamarla desde
+    // varios hilos con buffers distintos.
+    void layoutBand(const std::string& glyphs, const size_t rowBytes[], int padding,
+                    std::string& output) const {
+        size_t total = 0;
+        for (int line = 0; line < glyphRows; line++) total += padding + rowBytes[line] + 1;
         
-        // Imprimir borde inferior
-        std::cout << std::string(width + 4, borderChar) << std::endl;
+        size_t start = output.size();
+        output.resize(start + total + ROW_SLACK);
+        char* out = &output[start];
+        for (int line = 0; line < glyphRows; line++) {
+            out = appendFill(out, padding, ' ');
+            out = appendRow(out, glyphs, line);
+            *out++ = '\n';
+        }
+        output.resize(start + total);
     }
     
-    void printCentered(const std::string& text, int totalWidth = 80) {
-        std::string upperText = text;
-        std::transform(upperText.begin(), upperText.end(), upperText.begin(), ::toupper);
+    // nullptr es std::cout; se resuelve al escribir para que el puntero no
+    // apunte a un miembro y un FigPrinter movido siga siendo válido
+    OutputSink* sink = nullptr;
+    
+    void write(std::string_view out) const {
+        static OstreamSink coutSink{std::cout};
+        OutputSink* target = sink ? sink : &coutSink;
+        target->write(out.data(), out.size());
+    }
+    
+    // Caché LRU opcional de salidas ya renderizadas. La clave usa el texto
+    // original (antes de pasarlo a mayúsculas), así un acierto no repite
+    // ningún trabajo.
+    enum RenderMode { MODE_TEXT, MODE_BANNER, MODE_CENTERED };
+    
+    struct CacheKey {
+        std::string text;
+        int mode;
+        char borderChar;
+        int totalWidth;
         
-        // Calcular ancho del texto
-        int textWidth = 0;
-        for (char c : upperText) {
-            if (charMap.find(c) != charMap.end()) {
-                textWidth += charMap[c][0].length();
+        bool operator==(const CacheKey& other) const {
+            return mode == other.mode && borderChar == other.borderChar &&
+                   totalWidth == other.totalWidth && text == other.text;
+        }
+    };
+    
+    struct CacheKeyHash {
+        size_t operator()(const CacheKey& key) const {
+            size_t h = std::hash<std::string>()(key.text);
+            h ^= (static_cast<size_t>(key.mode) << 8 | static_cast<unsigned char>(key.borderChar)) +
+                 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h ^= static_cast<size_t>(key.totalWidth) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+    
+    typedef std::list<std::pair<CacheKey, std::string>> CacheList;
+    CacheList cacheList; // el más reciente al frente
+    std::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash> cacheIndex;
+    size_t cacheCapacity = 0; // 0 = caché desactivada
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    CacheKey lookupKey; // reutilizada para no reservar memoria en cada búsqueda
+    
+    template <typename Layout>
+    std::string_view renderCached(RenderMode mode, const std::string& text, char borderChar,
+                                  int totalWidth, Layout&& layout) {
+        if (cacheCapacity == 0) return layout();
+        
+        lookupKey.text.assign(text);
+        lookupKey.mode = mode;
+        lookupKey.borderChar = borderChar;
+        lookupKey.totalWidth = totalWidth;
+        
+        std::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash>::iterator it = cacheIndex.find(lookupKey);
+        if (it != cacheIndex.end()) {
+            cacheHits++;
+            cacheList.splice(cacheList.begin(), cacheList, it->second);
+            return it->second->second;
+        }
+        
+        cacheMisses++;
+        std::string_view out = layout();
+        if (cacheList.size() >= cacheCapacity) {
+            cacheIndex.erase(cacheList.back().first);
+            cacheList.pop_back();
+        }
+        cacheList.emplace_front(lookupKey, std::string(out));
+        cacheIndex.emplace(cacheList.front().first, cacheList.begin());
+        return out;
+    }
+    
+    // Elimina las entradas cuyo texto usa el carácter ch
+    void invalidateCache(char ch) {
+        if (cacheList.empty()) return;
+        
+        // '?' también se usa para todos los caracteres sin glifo
+        if (ch == '?') {
+            cacheList.clear();
+            cacheIndex.clear();
+            return;
+        }
+        
+        for (CacheList::iterator it = cacheList.begin(); it != cacheList.end();) {
+            bool uses = false;
+            for (char c : it->first.text) {
+                if (std::toupper(static_cast<unsigned char>(c)) == static_cast<unsigned char>(ch)) {
+                    uses = true;
+                    break;
+                }
+            }
+            if (uses) {
+                cacheIndex.erase(it->first);
+                it = cacheList.erase(it);
             } else {
-                textWidth += charMap['?'][0].length();
+                ++it;
             }
         }
+    }
+    
+    std::string_view layoutText(const std::string& text) {
+        if (text.empty()) return std::string_view();
+        
+        // Convertir a mayúsculas
+        prepareText(text);
+        
+        size_t rowBytes[MAX_GLYPH_ROWS];
+        measureRows(upperText, rowBytes);
+        
+        // Renderizar línea por línea
+        renderBuffer.clear();
+        layoutBand(upperText, rowBytes, 0, renderBuffer);
+        return renderBuffer;
+    }
+    
+    std::string_view layoutBanner(const std::string& text, char borderChar) {
+        prepareText(text);
+        
+        // Calcular ancho del banner
+        size_t rowBytes[MAX_GLYPH_ROWS];
+        measureRows(upperText, rowBytes);
+        size_t width = rowBytes[0];
+        
+        size_t total = 2 * (width + 5);
+        for (int line = 0; line < glyphRows; line++) total += rowBytes[line] + 5;
+        
+        renderBuffer.resize(total + ROW_SLACK);
+        char* out = &renderBuffer[0];
         
+        // Borde superior
+        out = appendFill(out, width + 4, borderChar);
+        *out++ = '\n';
+        
+        // Texto con bordes laterales
+        for (int line = 0; line < glyphRows; line++) {
+            *out++ = borderChar;
+            *out++ = ' ';
+            out = appendRow(out, upperText, line);
+            *out++ = ' ';
+            *out++ = borderChar;
+            *out++ = '\n';
+        }
+        
+        // Borde inferior
+        out = appendFill(out, width + 4, borderChar);
+        *out++ = '\n';
+        renderBuffer.resize(total);
+        return renderBuffer;
+    }
+    
+    std::string_view layoutCentered(const std::string& text, int totalWidth) {
+        prepareText(text);
+        
+        // Calcular ancho del texto
+        size_t rowBytes[MAX_GLYPH_ROWS];
+        measureRows(upperText, rowBytes);
+        
+        // Renderizar línea por línea centrado
+        renderBuffer.clear();
+        layoutBand(upperText, rowBytes, centerPadding(rowBytes, totalWidth), renderBuffer);
+        return renderBuffer;
+    }
+    
+    static int centerPadding(const size_t rowBytes[], int totalWidth) {
+        int textWidth = static_cast<int>(rowBytes[0]);
         int padding = (totalWidth - textWidth) / 2;
         if (padding < 0) padding = 0;
+        return padding;
+    }
+    
+    // Maquetación por streaming: lee el documento por bloques, lo corta en
+    // palabras y las acomoda en bandas que no pasan de totalWidth. Cada banda
+    // (ya en mayúsculas) se entrega a onBand en cuanto está completa, así que la
+    // memoria queda acotada a una banda. Un salto de línea cierra la banda y
+    // una palabra más ancha que la línea se corta por glifo.
+    template <typename OnBand>
+    size_t wrapDocument(std::istream& input, int totalWidth, OnBand&& onBand) {
+        const size_t width = totalWidth > 0 ? static_cast<size_t>(totalWidth) : 1;
+        ensureGlyph(' ');
+        const size_t spaceWidth = glyphWidth(' ');
+        
+        std::string band;
+        std::string word;
+        size_t bandWidth = 0;
+        size_t wordWidth = 0;
+        
+        auto flushBand = [&]() {
+            if (band.empty()) return;
+            onBand(band);
+            band.clear();
+            bandWidth = 0;
+        };
+        auto flushWord = [&]() {
+            if (word.empty()) return;
+            if (!band.empty() && bandWidth + spaceWidth + wordWidth > width) flushBand();
+            if (!band.empty()) {
+                band += ' ';
+                bandWidth += spaceWidth;
+            }
+            band += word;
+            bandWidth += wordWidth;
+            word.clear();
+            wordWidth = 0;
+        };
         
-        // Imprimir línea por línea centrado
-        for (int line = 0; line < 7; line++) {
-            std::cout << std::string(padding, ' ');
-            for (char c : upperText) {
+        char chunk[65536];
+        size_t processed = 0;
+        while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+            size_t count = static_cast<size_t>(input.gcount());
+            processed += count;
+            for (size_t i = 0; i < count; i++) {
+                unsigned char c = static_cast<unsigned char>(chunk[i]);
+                if (c == '\n') {
+                    flushWord();
+                    flushBand();
+                } else if (c == ' ' || c == '\t' || c == '\r') {
+                    flushWord();
+                } else {
+                    char glyph = static_cast<char>(std::toupper(c));
+                    ensureGlyph(glyph);
+                    size_t w = glyphWidth(glyph);
+                    if (!word.empty() && wordWidth + w > width) {
+                        flushWord();
+                        flushBand();
+                    }
+                    word += glyph;
+                    wordWidth += w;
+                }
+            }
+        }
+        flushWord();
+        flushBand();
+        return processed;
+    }
+    
+public:
+    FigPrinter() {
+        initializeCharMap();
+        buildAtlas();
+    }
+    
+    // Los métodos render* dejan la salida completa en un buffer del tamaño
+    // exacto (o la toman de la caché) y devuelven una vista que es válida
+    // hasta la siguiente llamada a render*, print*, addCustomChar o enableCache.
+    std::string_view renderText(const std::string& text) {
+        return renderCached(MODE_TEXT, text, 0, 0, [&]() { return layoutText(text); });
+    }
+    
+    std::string_view renderBanner(const std::string& text, char borderChar = '*') {
+        return renderCached(MODE_BANNER, text, borderChar, 0,
+                            [&]() { return layoutBanner(text, borderChar); });
+    }
+    
+    std::string_view renderCentered(const std::string& text, int totalWidth = 80) {
+        return renderCached(MODE_CENTERED, text, 0, totalWidth,
+                            [&]() { return layoutCentered(text, totalWidth); });
+    }
+    
+    // Cada print* escribe todo con una sola llamada y sin vaciar por línea
+    void printText(const std::string& text) {
+        write(renderText(text));
+    }
+    
+    void printBanner(const std::string& text, char borderChar = '*') {
+        write(renderBanner(text, borderChar));
+    }
+    
+    void printCentered(const std::string& text, int totalWidth = 80) {
+        write(renderCentered(text, totalWidth));
+    }
+    
+    // Imprime un documento de cualquier largo con ajuste de línea por palabras,
+    // una banda de 7 filas a la vez. Devuelve la cantidad de bytes leídos.
+    size_t printDocument(std::istream& input, int totalWidth = 80, bool centered = false) {
+        return wrapDocument(input, totalWidth, [&](const std::string& band) {
+            size_t rowBytes[MAX_GLYPH_ROWS];
+            measureRows(band, rowBytes);
+            renderBuffer.clear();
+            layoutBand(band, rowBytes, centered ? centerPadding(rowBytes, totalWidth) : 0, renderBuffer);
+            write(renderBuffer);
+        });
+    }
+    
+    // Igual que printDocument, pero las bandas se renderizan en paralelo: se
+    // juntan lotes de bandas, cada hilo renderiza en su propio buffer y los
+    // buffers se escriben en orden, así la salida es idéntica byte a byte.
+    size_t printDocumentParallel(std::istream& input, int totalWidth = 80, bool centered = false,
+                                 unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t batchSize = 64 * threads;
+        
+        RenderPool pool(threads);
+        std::vector<std::string> bands(batchSize);
+        std::vector<std::string> outputs(batchSize);
+        size_t pending = 0;
+        
+        std::function<void(size_t)> renderBand = [&](size_t i) {
+            size_t rowBytes[MAX_GLYPH_ROWS];
+            measureRows(bands[i], rowBytes);
+            outputs[i].clear();
+            layoutBand(bands[i], rowBytes, centered ? centerPadding(rowBytes, totalWidth) : 0, outputs[i]);
+        };
+        auto flushBatch = [&]() {
+            pool.run(pending, renderBand);
+            for (size_t i = 0; i < pending; i++) write(outputs[i]);
+            pending = 0;
+        };
+        
+        size_t processed = wrapDocument(input, totalWidth, [&](const std::string& band) {
+            bands[pending++] = band;
+            if (pending == batchSize) flushBatch();
+        });
+        if (pending > 0) flushBatch();
+        return processed;
+    }
+    
+    void addCustomChar(char ch, const std::vector<std::string>& pattern) {
+        if (pattern.size() == static_cast<size_t>(glyphRows)) {
+            charMap[ch] = pattern;
+            buildAtlas();
+            invalidateCache(ch);
+        }
+    }
+    
+    // Activa la caché LRU con la capacidad dada (0 la desactiva)
+    void enableCache(size_t capacity) {
+        cacheCapacity = capacity;
+        cacheList.clear();
+        cacheIndex.clear();
+        cacheHits = 0;
+        cacheMisses = 0;
+    }
+    
+    // Reemplaza la fuente integrada por una fuente FIGlet (.flf). Abrirla
+    // cuesta lo mismo sin importar el tamaño del archivo: los glifos se buscan
+    // y decodifican la primera vez que se usan. addCustomChar sigue
+    // funcionando, con patrones de tantas filas como la altura de la fuente.
+    bool loadFont(const std::string& path) {
+        std::unique_ptr<FigletFont> loaded(new FigletFont());
+        if (!loaded->open(path) || loaded->getHeight() > MAX_GLYPH_ROWS) return false;
+        
+        font = std::move(loaded);
+        glyphRows = font->getHeight();
+        charMap.clear();
+        buildAtlas();
+        cacheList.clear();
+        cacheIndex.clear();
+        return true;
+    }
+    
+    int getGlyphRows() const {
+        return glyphRows;
+    }
+    
+    // Cambia el destino de la salida (nullptr vuelve a std::cout). El sink no
+    // pasa a ser de FigPrinter y debe vivir mientras se use.
+    void setSink(OutputSink* newSink) {
+        sink = newSink;
+    }
+    
+    struct CacheStats {
+        size_t hits;
+        size_t misses;
+        size_t size;
+        size_t capacity;
+        
+        double hitRate() const {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+        }
+    };
+    
+    CacheStats getCacheStats() const {
+        return {cacheHits, cacheMisses, cacheList.size(), cacheCapacity};
+    }
+};
+
+// Compara el renderizado original (búsquedas en std::map y escritura por
+// partes con std::endl) contra el atlas plano y los glifos empaquetados. La
+// salida se redirige a un buffer en memoria.
+void benchmarkGlyphLookup() {
+    FigPrinter printer;
+    const std::string text = "HELLO WORLD CODE ORDER ABCDEHLOR?";
+    const int iterations = 20000;
+    
+    std::ostringstream sink;
+    std::streambuf* original = std::cout.rdbuf(sink.rdbuf());
+    
+    auto legacy = [&]() {
+        std::map<char, std::vector<std::string>>& charMap = printer.charMap;
+        for (int line = 0; line < printer.glyphRows; line++) {
+            for (char c : text) {
                 if (charMap.find(c) != charMap.end()) {
                     std::cout << charMap[c][line];
                 } else {
@@ -220,17 +1153,227 @@ public:
             }
             std::cout << std::endl;
         }
+    };
+    auto atlas = [&]() {
+        printer.printText(text);
+    };
+    
+    auto measure = [&](auto&& render) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            sink.str(std::string());
+            render();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() /
+               (static_cast<double>(iterations) * text.size());
+    };
+    
+    double legacyNs = measure(legacy);
+    double packedNs = measure(atlas);
+    printer.packingEnabled = false;
+    printer.buildAtlas();
+    double atlasNs = measure(atlas);
+    printer.packingEnabled = true;
+    printer.buildAtlas();
+    std::cout.rdbuf(original);
+    
+    std::cout << "std::map:     " << legacyNs << " ns/glifo" << std::endl;
+    std::cout << "atlas+buffer: " << atlasNs << " ns/glifo" << std::endl;
+    std::cout << "empaquetado:  " << packedNs << " ns/glifo" << std::endl;
+    std::cout << "aceleración:  " << legacyNs / packedNs << "x" << std::endl;
+}
+
+// Caché: textos de estado que se repiten, con aciertos y fallos medidos aparte
+void benchmarkCache() {
+    FigPrinter printer;
+    const std::vector<std::string> statuses = {
+        "OK", "ERROR", "HOLA", "CODE", "ORDER", "DEBE", "LLEGAR", "ADIOS"
+    };
+    auto measureCalls = [&](int rounds) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            for (const std::string& status : statuses) {
+                printer.renderBanner(status, '#');
+                printer.renderCentered(status, 60);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() /
+               (static_cast<double>(rounds) * statuses.size() * 2);
+    };
+    
+    double uncachedNs = measureCalls(2000);
+    
+    printer.enableCache(64);
+    double missNs = measureCalls(1);
+    double hitNs = measureCalls(2000);
+    FigPrinter::CacheStats stats = printer.getCacheStats();
+    
+    std::cout << "sin caché:     " << uncachedNs << " ns/llamada" << std::endl;
+    std::cout << "caché fallo:   " << missNs << " ns/llamada" << std::endl;
+    std::cout << "caché acierto: " << hitNs << " ns/llamada" << std::endl;
+    std::cout << "tasa de aciertos: " << stats.hitRate() * 100 << "% ("
+              << stats.hits << " aciertos, " << stats.misses << " fallos)" << std::endl;
+}
+
+// Documento largo con ajuste de línea, en serie y con bandas en paralelo
+// Se llama después de devNull.flush(): si alguna escritura falló, lo medido
+// no llegó al destino y las cifras no valen
+bool sinkFailed(const OutputSink& sink) {
+    if (!sink.failed()) return false;
+    std::cerr << "Error: falló la escritura al destino; se descartan las mediciones" << std::endl;
+    return true;
+}
+
+void benchmarkDocument(OutputSink& devNull) {
+    const char* words[] = {"hello", "code", "order", "error", "held", "load", "role", "[ok]"};
+    std::string document;
+    for (size_t i = 0; document.size() < 8 * 1024 * 1024; i++) {
+        document += words[(i * 7 + i / 3) % 8];
+        document += (i % 12 == 11) ? '\n' : ' ';
     }
     
-    void addCustomChar(char ch, const std::vector<std::string>& pattern) {
-        if (pattern.size() == 7) {
-            charMap[ch] = pattern;
+    FigPrinter printer;
+    printer.setSink(&devNull);
+    std::istringstream input(document);
+    auto start = std::chrono::steady_clock::now();
+    size_t processed = printer.printDocument(input, 120);
+    devNull.flush();
+    auto end = std::chrono::steady_clock::now();
+    if (sinkFailed(devNull)) return;
+    
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "documento:     " << processed / seconds / 1e6 << " M caracteres/s ("
+              << processed << " bytes en " << seconds << " s)" << std::endl;
+    
+    // Se comprueba que la salida en paralelo sea idéntica a la serial
+    MemorySink serialOut;
+    std::istringstream serialIn(document);
+    printer.setSink(&serialOut);
+    printer.printDocument(serialIn, 120);
+    
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        std::istringstream parallelIn(document);
+        printer.setSink(&devNull);
+        start = std::chrono::steady_clock::now();
+        printer.printDocumentParallel(parallelIn, 120, false, threads);
+        devNull.flush();
+        end = std::chrono::steady_clock::now();
+        if (sinkFailed(devNull)) return;
+        
+        MemorySink parallelOut;
+        std::istringstream checkIn(document);
+        printer.setSink(&parallelOut);
+        printer.printDocumentParallel(checkIn, 120, false, threads);
+        
+        seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "paralelo (" << threads << " hilos): " << processed / seconds / 1e6
+                  << " M caracteres/s, salida "
+                  << (parallelOut.str() == serialOut.str() ? "idéntica" : "DIFERENTE") << std::endl;
+        if (threads == maxThreads) break;
+    }
+}
+
+// Rendimiento de printText, printBanner y printCentered según el largo del
+// texto, escribiendo a memoria y a un sink de descriptor (/dev/null)
+void benchmarkThroughput(OutputSink& devNull) {
+    const size_t lengths[] = {8, 64, 512, 4096};
+    const size_t glyphsPerRun = 4000000;
+    
+    std::cout << "método          largo  destino      M glifos/s       MB/s" << std::endl;
+    for (int method = 0; method < 3; method++) {
+        for (size_t length : lengths) {
+            std::string text;
+            while (text.size() < length) text += "HELLO CODE ";
+            text.resize(length);
+            int width = static_cast<int>(length) * 8 + 20;
+            
+            for (int target = 0; target < 2; target++) {
+                FigPrinter printer;
+                MemorySink memory;
+                printer.setSink(target == 0 ? static_cast<OutputSink*>(&memory) : &devNull);
+                
+                size_t iterations = std::max<size_t>(1, glyphsPerRun / length);
+                size_t bytes = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < iterations; i++) {
+                    if (method == 0) printer.printText(text);
+                    else if (method == 1) printer.printBanner(text, '#');
+                    else printer.printCentered(text, width);
+                    
+                    if (target == 0) {
+                        bytes += memory.str().size();
+                        memory.clear();
+                    }
+                }
+                devNull.flush();
+                auto end = std::chrono::steady_clock::now();
+                if (sinkFailed(devNull)) return;
+                
+                if (target == 1) {
+                    // Mismo tamaño de salida que en memoria, sin volver a medirlo
+                    MemorySink probe;
+                    printer.setSink(&probe);
+                    if (method == 0) printer.printText(text);
+                    else if (method == 1) printer.printBanner(text, '#');
+                    else printer.printCentered(text, width);
+                    bytes = probe.str().size() * iterations;
+                }
+                
+                static const char* methods[] = {"printText", "printBanner", "printCentered"};
+                double seconds = std::chrono::duration<double>(end - start).count();
+                std::printf("%-14s %6zu  %-10s %12.2f %10.1f\n", methods[method], length,
+                            target == 0 ? "memoria" : "/dev/null",
+                            iterations * length / seconds / 1e6, bytes / seconds / 1e6);
+            }
         }
     }
-};
+}
+
+void benchmarkFigPrinter() {
+    benchmarkGlyphLookup();
+    benchmarkCache();
+    
+#ifndef _WIN32
+    int fd = ::open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        std::cerr << "Error: No se pudo abrir /dev/null" << std::endl;
+        return;
+    }
+    {
+        FdSink devNull(fd);
+        benchmarkDocument(devNull);
+        benchmarkThroughput(devNull);
+        if (devNull.failed()) std::cerr << "Error: /dev/null: " << std::strerror(devNull.lastError()) << std::endl;
+    }
+    close(fd);
+#else
+    MemorySink devNull;
+    benchmarkDocument(devNull);
+    benchmarkThroughput(devNull);
+#endif
+}
 
 // Función de demostración
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        benchmarkFigPrinter();
+        return 0;
+    }
+    
+    // Uso con una fuente FIGlet: FigPrinter --font archivo.flf [texto]
+    if (argc > 2 && std::strcmp(argv[1], "--font") == 0) {
+        FigPrinter printer;
+        if (!printer.loadFont(argv[2])) {
+            std::cerr << "Error: No se pudo cargar la fuente " << argv[2] << std::endl;
+            return 1;
+        }
+        printer.printText(argc > 3 ? argv[3] : "Hello");
+        return 0;
+    }
+    
     FigPrinter printer;
     
     std::cout << "=== DEMO FigPrinter ===" << std::endl << std::endl;
@@ -264,6 +1407,12 @@ int main() {
     
     std::cout << "Caracter personalizado:" << std::endl;
     printer.printText("@");
+    std::cout << std::endl;
+    
+    // Documento con ajuste de línea por palabras
+    std::cout << "Documento con ajuste de línea:" << std::endl;
+    std::istringstream document("hello code order\nheld role");
+    printer.printDocument(document, 40);
     
     return 0;
 }
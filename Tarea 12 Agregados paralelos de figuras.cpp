@@ -0,0 +1,348 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+// Tipos de figura, usados para agregar el área por tipo
+enum TipoFigura {
+    CIRCULO,
+    CUADRADO,
+    TRIANGULO,
+    NUM_TIPOS
+};
+
+const char* nombreTipo(TipoFigura tipo) {
+    switch (tipo) {
+        case CIRCULO:   return "círculo";
+        case CUADRADO:  return "cuadrado";
+        case TRIANGULO: return "triángulo";
+        default:        return "?";
+    }
+}
+
+// Clase abstracta base (igual que en act4, más el tipo de la figura)
+class FiguraGeometrica {
+public:
+    virtual double calcularArea() = 0;
+    virtual TipoFigura tipo() const = 0;
+    virtual ~FiguraGeometrica() {}
+};
+
+class Circulo : public FiguraGeometrica {
+private:
+    double radio;
+    double area;
+    bool areaCalculada;
+
+public:
+    Circulo(double r) : radio(r), area(0), areaCalculada(false) {}
+
+    double calcularArea() override {
+        if (!areaCalculada) {
+            area = M_PI * radio * radio;
+            areaCalculada = true;
+        }
+        return area;
+    }
+
+    TipoFigura tipo() const override { return CIRCULO; }
+};
+
+class Cuadrado : public FiguraGeometrica {
+private:
+    double lado;
+    double area;
+    bool areaCalculada;
+
+public:
+    Cuadrado(double l) : lado(l), area(0), areaCalculada(false) {}
+
+    double calcularArea() override {
+        if (!areaCalculada) {
+            area = lado * lado;
+            areaCalculada = true;
+        }
+        return area;
+    }
+
+    TipoFigura tipo() const override { return CUADRADO; }
+};
+
+class Triangulo : public FiguraGeometrica {
+private:
+    double base, altura;
+    double area;
+    bool areaCalculada;
+
+public:
+    Triangulo(double b, double h) : base(b), altura(h), area(0), areaCalculada(false) {}
+
+    double calcularArea() override {
+        if (!areaCalculada) {
+            area = (base * altura) / 2.0;
+            areaCalculada = true;
+        }
+        return area;
+    }
+
+    TipoFigura tipo() const override { return TRIANGULO; }
+};
+
+// Figura en almacenamiento contiguo (sin punteros ni tabla virtual).
+// a = radio / lado / base, b = altura (solo triángulo)
+struct FiguraPlana {
+    TipoFigura tipo;
+    double a;
+    double b;
+
+    double calcularArea() const {
+        switch (tipo) {
+            case CIRCULO:  return M_PI * a * a;
+            case CUADRADO: return a * a;
+            default:       return (a * b) / 2.0;
+        }
+    }
+};
+
+// Resultado de una consulta agregada
+struct ResultadoAgregado {
+    double areaTotal = 0;
+    double areaPorTipo[NUM_TIPOS] = {};
+    size_t conteoPorTipo[NUM_TIPOS] = {};
+    vector<pair<double, size_t>> mayores; // (área, índice), de mayor a menor
+};
+
+// Agregador paralelo: total, área por tipo y las k figuras más grandes.
+// Cada hilo toma bloques de un contador atómico compartido (los hilos que
+// terminan antes se quedan con el trabajo restante) y acumula en su propio
+// resultado parcial; los parciales se combinan al final.
+class AgregadorParalelo {
+private:
+    unsigned numHilos;
+    size_t tamBloque;
+
+    // Orden de las k mayores: mayor área primero; en empate, menor índice
+    // primero. Así el resultado no depende de cómo se repartieron los bloques.
+    struct MejorQue {
+        bool operator()(const pair<double, size_t>& x, const pair<double, size_t>& y) const {
+            return x.first != y.first ? x.first > y.first : x.second < y.second;
+        }
+    };
+
+    // Parcial por hilo alineado a línea de caché para evitar false sharing
+    struct alignas(64) Parcial {
+        double areaTotal = 0;
+        double areaPorTipo[NUM_TIPOS] = {};
+        size_t conteoPorTipo[NUM_TIPOS] = {};
+        // Las k mayores vistas por este hilo; en la cima queda la peor según
+        // MejorQue (menor área y, en empate, mayor índice)
+        priority_queue<pair<double, size_t>, vector<pair<double, size_t>>, MejorQue> mayores;
+    };
+
+    template <typename Acceso>
+    void procesarBloques(size_t n, size_t k, atomic<size_t>& siguiente,
+                         Parcial& parcial, Acceso& acceso) {
+        for (;;) {
+            size_t inicio = siguiente.fetch_add(tamBloque, memory_order_relaxed);
+            if (inicio >= n) break;
+            size_t fin = min(n, inicio + tamBloque);
+
+            for (size_t i = inicio; i < fin; ++i) {
+                TipoFigura tipo;
+                double area = acceso(i, tipo);
+                parcial.areaTotal += area;
+                parcial.areaPorTipo[tipo] += area;
+                parcial.conteoPorTipo[tipo]++;
+
+                if (k == 0) continue;
+                if (parcial.mayores.size() < k) {
+                    parcial.mayores.emplace(area, i);
+                } else if (MejorQue()(make_pair(area, i), parcial.mayores.top())) {
+                    parcial.mayores.pop();
+                    parcial.mayores.emplace(area, i);
+                }
+            }
+        }
+    }
+
+public:
+    AgregadorParalelo(unsigned hilos = 0, size_t bloque = 16384)
+        : numHilos(hilos), tamBloque(bloque) {
+        if (numHilos == 0) numHilos = max(1u, thread::hardware_concurrency());
+        if (tamBloque == 0) tamBloque = 1;
+    }
+
+    unsigned getNumHilos() const { return numHilos; }
+
+    // Versión genérica: acceso(i, tipo) devuelve el área de la figura i
+    // y escribe su tipo. Sirve para cualquier almacenamiento indexable.
+    template <typename Acceso>
+    ResultadoAgregado agregar(size_t n, size_t k, Acceso acceso) {
+        // No tiene sentido lanzar más hilos que bloques
+        size_t bloques = (n + tamBloque - 1) / tamBloque;
+        unsigned hilos = static_cast<unsigned>(max<size_t>(1, min<size_t>(numHilos, bloques)));
+
+        vector<Parcial> parciales(hilos);
+        atomic<size_t> siguiente(0);
+
+        vector<thread> trabajadores;
+        for (unsigned t = 1; t < hilos; ++t) {
+            trabajadores.emplace_back([&, t]() {
+                Acceso copia = acceso;
+                procesarBloques(n, k, siguiente, parciales[t], copia);
+            });
+        }
+        // El hilo que llama también trabaja
+        procesarBloques(n, k, siguiente, parciales[0], acceso);
+        for (auto& hilo : trabajadores) hilo.join();
+
+        // Combinar los parciales
+        ResultadoAgregado resultado;
+        for (auto& parcial : parciales) {
+            resultado.areaTotal += parcial.areaTotal;
+            for (int t = 0; t < NUM_TIPOS; ++t) {
+                resultado.areaPorTipo[t] += parcial.areaPorTipo[t];
+                resultado.conteoPorTipo[t] += parcial.conteoPorTipo[t];
+            }
+            while (!parcial.mayores.empty()) {
+                resultado.mayores.push_back(parcial.mayores.top());
+                parcial.mayores.pop();
+            }
+        }
+
+        sort(resultado.mayores.begin(), resultado.mayores.end(), MejorQue());
+        if (resultado.mayores.size() > k) resultado.mayores.resize(k);
+        return resultado;
+    }
+
+    // Arreglo de punteros a la clase base (como en act4)
+    ResultadoAgregado agregar(FiguraGeometrica* const* figuras, size_t n, size_t k) {
+        return agregar(n, k, [figuras](size_t i, TipoFigura& tipo) {
+            tipo = figuras[i]->tipo();
+            return figuras[i]->calcularArea();
+        });
+    }
+
+    // Almacenamiento contiguo
+    ResultadoAgregado agregar(const FiguraPlana* figuras, size_t n, size_t k) {
+        return agregar(n, k, [figuras](size_t i, TipoFigura& tipo) {
+            tipo = figuras[i].tipo;
+            return figuras[i].calcularArea();
+        });
+    }
+};
+
+void mostrarResultado(const ResultadoAgregado& resultado) {
+    cout << "Área total: " << resultado.areaTotal << endl;
+    for (int t = 0; t < NUM_TIPOS; ++t) {
+        cout << "  " << nombreTipo(static_cast<TipoFigura>(t)) << ": "
+             << resultado.conteoPorTipo[t] << " figuras, área "
+             << resultado.areaPorTipo[t] << endl;
+    }
+    cout << "Figuras más grandes:" << endl;
+    for (auto& par : resultado.mayores) {
+        cout << "  figura " << par.second << ": " << par.first << endl;
+    }
+}
+
+vector<FiguraPlana> generarFiguras(size_t n, unsigned semilla) {
+    mt19937 rng(semilla);
+    uniform_real_distribution<double> medida(0.5, 10.0);
+    uniform_int_distribution<int> tipo(0, NUM_TIPOS - 1);
+
+    vector<FiguraPlana> figuras(n);
+    for (auto& figura : figuras) {
+        figura.tipo = static_cast<TipoFigura>(tipo(rng));
+        figura.a = medida(rng);
+        figura.b = medida(rng);
+    }
+    return figuras;
+}
+
+// Comparación contra el ciclo secuencial de act4 con 1..N hilos
+void benchmark(size_t n) {
+    const size_t K = 10;
+    vector<FiguraPlana> planas = generarFiguras(n, 42);
+
+    vector<FiguraGeometrica*> punteros(n);
+    for (size_t i = 0; i < n; ++i) {
+        const FiguraPlana& f = planas[i];
+        if (f.tipo == CIRCULO) punteros[i] = new Circulo(f.a);
+        else if (f.tipo == CUADRADO) punteros[i] = new Cuadrado(f.a);
+        else punteros[i] = new Triangulo(f.a, f.b);
+    }
+    // Precalcular para que el área memorizada no distorsione la primera medición
+    for (auto* figura : punteros) figura->calcularArea();
+
+    auto medir = [](const char* nombre, unsigned hilos, size_t n, auto&& tarea) {
+        auto inicio = chrono::steady_clock::now();
+        double total = tarea();
+        auto fin = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(fin - inicio).count();
+        cout << nombre << " hilos=" << hilos << ": " << ms << " ms, "
+             << (n / ms / 1000.0) << " M figuras/s (total " << total << ")" << endl;
+    };
+
+    cout << "Figuras: " << n << endl;
+    medir("secuencial punteros", 1, n, [&]() {
+        double total = 0;
+        for (size_t i = 0; i < n; ++i) total += punteros[i]->calcularArea();
+        return total;
+    });
+
+    // 1, 2, 4, ... hasta todos los núcleos
+    unsigned maxHilos = max(1u, thread::hardware_concurrency());
+    vector<unsigned> conteos;
+    for (unsigned hilos = 1; hilos < maxHilos; hilos *= 2) conteos.push_back(hilos);
+    conteos.push_back(maxHilos);
+
+    for (unsigned hilos : conteos) {
+        AgregadorParalelo agregador(hilos);
+        medir("paralelo punteros  ", hilos, n, [&]() {
+            return agregador.agregar(punteros.data(), n, K).areaTotal;
+        });
+        medir("paralelo contiguo  ", hilos, n, [&]() {
+            return agregador.agregar(planas.data(), n, K).areaTotal;
+        });
+    }
+
+    for (auto* figura : punteros) delete figura;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        size_t n = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000;
+        benchmark(n);
+        return 0;
+    }
+
+    // Mismas figuras que en act4
+    FiguraGeometrica* figuras[3];
+    figuras[0] = new Circulo(5.0);
+    figuras[1] = new Cuadrado(4.0);
+    figuras[2] = new Triangulo(6.0, 3.0);
+
+    AgregadorParalelo agregador;
+    cout << "=== Arreglo de punteros (" << agregador.getNumHilos() << " hilos) ===" << endl;
+    mostrarResultado(agregador.agregar(figuras, 3, 2));
+
+    for (int i = 0; i < 3; ++i) {
+        delete figuras[i];
+    }
+
+    // Colección grande en almacenamiento contiguo
+    vector<FiguraPlana> planas = generarFiguras(1000000, 7);
+    cout << endl << "=== Almacenamiento contiguo (" << planas.size() << " figuras) ===" << endl;
+    mostrarResultado(agregador.agregar(planas.data(), planas.size(), 5));
+
+    return 0;
+}
@@ -0,0 +1,472 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+enum TipoFigura {
+    CIRCULO,
+    CUADRADO,
+    TRIANGULO
+};
+
+// Caja alineada a los ejes (bounding box)
+struct Caja {
+    double minX, minY, maxX, maxY;
+
+    bool intersecta(const Caja& otra) const {
+        return minX <= otra.maxX && otra.minX <= maxX &&
+               minY <= otra.maxY && otra.minY <= maxY;
+    }
+};
+
+struct Punto {
+    double x, y;
+};
+
+// Figura con posición. (x, y) es el centro de la figura:
+//  - círculo:   a = radio
+//  - cuadrado:  a = lado (alineado a los ejes)
+//  - triángulo: a = base, b = altura (base horizontal abajo, vértice arriba al centro)
+struct FiguraPosicionada {
+    TipoFigura tipo;
+    double x, y;
+    double a, b;
+
+    static FiguraPosicionada circulo(double x, double y, double radio) {
+        return {CIRCULO, x, y, radio, 0};
+    }
+    static FiguraPosicionada cuadrado(double x, double y, double lado) {
+        return {CUADRADO, x, y, lado, 0};
+    }
+    static FiguraPosicionada triangulo(double x, double y, double base, double altura) {
+        return {TRIANGULO, x, y, base, altura};
+    }
+
+    double calcularArea() const {
+        switch (tipo) {
+            case CIRCULO:  return M_PI * a * a;
+            case CUADRADO: return a * a;
+            default:       return (a * b) / 2.0;
+        }
+    }
+
+    Caja caja() const {
+        switch (tipo) {
+            case CIRCULO:  return {x - a, y - a, x + a, y + a};
+            case CUADRADO: return {x - a / 2, y - a / 2, x + a / 2, y + a / 2};
+            default:       return {x - a / 2, y - b / 2, x + a / 2, y + b / 2};
+        }
+    }
+
+    // Vértices en sentido antihorario (solo cuadrado y triángulo)
+    int vertices(Punto salida[4]) const {
+        if (tipo == CUADRADO) {
+            double m = a / 2;
+            salida[0] = {x - m, y - m};
+            salida[1] = {x + m, y - m};
+            salida[2] = {x + m, y + m};
+            salida[3] = {x - m, y + m};
+            return 4;
+        }
+        salida[0] = {x - a / 2, y - b / 2};
+        salida[1] = {x + a / 2, y - b / 2};
+        salida[2] = {x, y + b / 2};
+        return 3;
+    }
+};
+
+// =================== PRUEBAS DE INTERSECCIÓN EXACTAS ===================
+
+// Teorema del eje separador entre dos polígonos convexos
+bool poligonosSeSolapan(const Punto* p, int np, const Punto* q, int nq) {
+    for (int figura = 0; figura < 2; ++figura) {
+        const Punto* pol = figura == 0 ? p : q;
+        int n = figura == 0 ? np : nq;
+        for (int i = 0; i < n; ++i) {
+            const Punto& v1 = pol[i];
+            const Punto& v2 = pol[(i + 1) % n];
+            double ejeX = -(v2.y - v1.y);
+            double ejeY = v2.x - v1.x;
+
+            double minP = INFINITY, maxP = -INFINITY;
+            for (int j = 0; j < np; ++j) {
+                double proy = p[j].x * ejeX + p[j].y * ejeY;
+                minP = min(minP, proy);
+                maxP = max(maxP, proy);
+            }
+            double minQ = INFINITY, maxQ = -INFINITY;
+            for (int j = 0; j < nq; ++j) {
+                double proy = q[j].x * ejeX + q[j].y * ejeY;
+                minQ = min(minQ, proy);
+                maxQ = max(maxQ, proy);
+            }
+            if (maxP < minQ || maxQ < minP) return false;
+        }
+    }
+    return true;
+}
+
+double distancia2PuntoSegmento(const Punto& c, const Punto& s1, const Punto& s2) {
+    double dx = s2.x - s1.x, dy = s2.y - s1.y;
+    double largo2 = dx * dx + dy * dy;
+    double t = largo2 > 0 ? ((c.x - s1.x) * dx + (c.y - s1.y) * dy) / largo2 : 0;
+    t = max(0.0, min(1.0, t));
+    double px = s1.x + t * dx - c.x;
+    double py = s1.y + t * dy - c.y;
+    return px * px + py * py;
+}
+
+// Círculo contra polígono convexo antihorario
+bool circuloSolapaPoligono(const Punto& c, double radio, const Punto* pol, int n) {
+    bool dentro = true;
+    for (int i = 0; i < n; ++i) {
+        const Punto& v1 = pol[i];
+        const Punto& v2 = pol[(i + 1) % n];
+        double cruz = (v2.x - v1.x) * (c.y - v1.y) - (v2.y - v1.y) * (c.x - v1.x);
+        if (cruz < 0) {
+            dentro = false;
+            break;
+        }
+    }
+    if (dentro) return true;
+
+    for (int i = 0; i < n; ++i) {
+        if (distancia2PuntoSegmento(c, pol[i], pol[(i + 1) % n]) <= radio * radio) return true;
+    }
+    return false;
+}
+
+bool seSolapan(const FiguraPosicionada& f, const FiguraPosicionada& g) {
+    if (!f.caja().intersecta(g.caja())) return false;
+
+    if (f.tipo == CIRCULO && g.tipo == CIRCULO) {
+        double dx = f.x - g.x, dy = f.y - g.y, r = f.a + g.a;
+        return dx * dx + dy * dy <= r * r;
+    }
+
+    Punto pf[4], pg[4];
+    if (f.tipo == CIRCULO) {
+        int n = g.vertices(pg);
+        return circuloSolapaPoligono({f.x, f.y}, f.a, pg, n);
+    }
+    if (g.tipo == CIRCULO) {
+        int n = f.vertices(pf);
+        return circuloSolapaPoligono({g.x, g.y}, g.a, pf, n);
+    }
+    int nf = f.vertices(pf);
+    int ng = g.vertices(pg);
+    return poligonosSeSolapan(pf, nf, pg, ng);
+}
+
+bool intersectaRegion(const FiguraPosicionada& f, const Caja& region) {
+    if (!f.caja().intersecta(region)) return false;
+    // La caja de un cuadrado es el propio cuadrado
+    if (f.tipo == CUADRADO) return true;
+
+    Punto rect[4] = {
+        {region.minX, region.minY}, {region.maxX, region.minY},
+        {region.maxX, region.maxY}, {region.minX, region.maxY}
+    };
+    if (f.tipo == CIRCULO) return circuloSolapaPoligono({f.x, f.y}, f.a, rect, 4);
+
+    Punto pf[4];
+    int n = f.vertices(pf);
+    return poligonosSeSolapan(pf, n, rect, 4);
+}
+
+// =================== ÍNDICE ESPACIAL (REJILLA UNIFORME) ===================
+
+// Rejilla uniforme: cada figura se registra en todas las celdas que toca su caja.
+// - construir(): carga masiva en formato compacto (conteo + suma de prefijos)
+// - insertar(): inserción incremental en listas enlazadas por celda
+// - consultarRegion() / paresSolapados(): candidatos por celda + prueba exacta.
+// Para no reportar dos veces lo que aparece en varias celdas, un resultado solo
+// se reporta en la celda que contiene la esquina mínima de la intersección.
+class IndiceEspacial {
+private:
+    Caja mundo;
+    double invCelda;
+    int celdasX, celdasY;
+
+    vector<FiguraPosicionada> figuras;
+    vector<Caja> cajas;
+
+    // Parte compacta (carga masiva)
+    vector<uint32_t> inicioCelda; // celdasX * celdasY + 1
+    vector<uint32_t> idsCompactos;
+
+    // Parte incremental: lista enlazada por celda
+    struct Nodo {
+        uint32_t id;
+        int32_t siguiente;
+    };
+    vector<int32_t> cabezaExtra;
+    vector<Nodo> nodosExtra;
+
+    int celdaX(double x) const {
+        int c = static_cast<int>(floor((x - mundo.minX) * invCelda));
+        return max(0, min(celdasX - 1, c));
+    }
+
+    int celdaY(double y) const {
+        int c = static_cast<int>(floor((y - mundo.minY) * invCelda));
+        return max(0, min(celdasY - 1, c));
+    }
+
+    template <typename Funcion>
+    void recorrerCelda(int cx, int cy, Funcion&& funcion) const {
+        int celda = cy * celdasX + cx;
+        for (uint32_t i = inicioCelda[celda]; i < inicioCelda[celda + 1]; ++i) {
+            funcion(idsCompactos[i]);
+        }
+        for (int32_t n = cabezaExtra[celda]; n >= 0; n = nodosExtra[n].siguiente) {
+            funcion(nodosExtra[n].id);
+        }
+    }
+
+    // ¿Es (cx, cy) la celda que contiene la esquina mínima de a ∩ b?
+    bool esCeldaDeReferencia(int cx, int cy, const Caja& a, const Caja& b) const {
+        return celdaX(max(a.minX, b.minX)) == cx && celdaY(max(a.minY, b.minY)) == cy;
+    }
+
+public:
+    IndiceEspacial(const Caja& limites, double celda)
+        : mundo(limites), invCelda(1.0 / celda) {
+        celdasX = max(1, static_cast<int>(ceil((mundo.maxX - mundo.minX) * invCelda)));
+        celdasY = max(1, static_cast<int>(ceil((mundo.maxY - mundo.minY) * invCelda)));
+        inicioCelda.assign(static_cast<size_t>(celdasX) * celdasY + 1, 0);
+        cabezaExtra.assign(static_cast<size_t>(celdasX) * celdasY, -1);
+    }
+
+    size_t size() const { return figuras.size(); }
+    const FiguraPosicionada& getFigura(uint32_t id) const { return figuras[id]; }
+
+    // Carga masiva: reemplaza el contenido del índice
+    void construir(vector<FiguraPosicionada> nuevas) {
+        figuras = std::move(nuevas);
+        cajas.resize(figuras.size());
+        for (size_t i = 0; i < figuras.size(); ++i) cajas[i] = figuras[i].caja();
+
+        nodosExtra.clear();
+        fill(cabezaExtra.begin(), cabezaExtra.end(), -1);
+        fill(inicioCelda.begin(), inicioCelda.end(), 0);
+
+        // 1) Contar entradas por celda
+        for (const Caja& c : cajas) {
+            for (int cy = celdaY(c.minY); cy <= celdaY(c.maxY); ++cy)
+                for (int cx = celdaX(c.minX); cx <= celdaX(c.maxX); ++cx)
+                    inicioCelda[cy * celdasX + cx + 1]++;
+        }
+        // 2) Suma de prefijos
+        for (size_t i = 1; i < inicioCelda.size(); ++i) inicioCelda[i] += inicioCelda[i - 1];
+
+        // 3) Llenar
+        idsCompactos.resize(inicioCelda.back());
+        vector<uint32_t> cursor(inicioCelda.begin(), inicioCelda.end() - 1);
+        for (uint32_t id = 0; id < cajas.size(); ++id) {
+            const Caja& c = cajas[id];
+            for (int cy = celdaY(c.minY); cy <= celdaY(c.maxY); ++cy)
+                for (int cx = celdaX(c.minX); cx <= celdaX(c.maxX); ++cx)
+                    idsCompactos[cursor[cy * celdasX + cx]++] = id;
+        }
+    }
+
+    // Inserción incremental; devuelve el id de la figura
+    uint32_t insertar(const FiguraPosicionada& figura) {
+        uint32_t id = static_cast<uint32_t>(figuras.size());
+        figuras.push_back(figura);
+        cajas.push_back(figura.caja());
+
+        const Caja& c = cajas.back();
+        for (int cy = celdaY(c.minY); cy <= celdaY(c.maxY); ++cy) {
+            for (int cx = celdaX(c.minX); cx <= celdaX(c.maxX); ++cx) {
+                int celda = cy * celdasX + cx;
+                nodosExtra.push_back({id, cabezaExtra[celda]});
+                cabezaExtra[celda] = static_cast<int32_t>(nodosExtra.size() - 1);
+            }
+        }
+        return id;
+    }
+
+    // Figuras que intersectan la región
+    void consultarRegion(const Caja& region, vector<uint32_t>& resultado) const {
+        resultado.clear();
+        for (int cy = celdaY(region.minY); cy <= celdaY(region.maxY); ++cy) {
+            for (int cx = celdaX(region.minX); cx <= celdaX(region.maxX); ++cx) {
+                recorrerCelda(cx, cy, [&](uint32_t id) {
+                    const Caja& c = cajas[id];
+                    if (!c.intersecta(region)) return;
+                    if (!esCeldaDeReferencia(cx, cy, c, region)) return;
+                    if (intersectaRegion(figuras[id], region)) resultado.push_back(id);
+                });
+            }
+        }
+    }
+
+    // Llama a funcion(id1, id2) una vez por cada par de figuras que se solapan
+    template <typename Funcion>
+    void paresSolapados(Funcion&& funcion) const {
+        vector<uint32_t> candidatos;
+        for (int cy = 0; cy < celdasY; ++cy) {
+            for (int cx = 0; cx < celdasX; ++cx) {
+                candidatos.clear();
+                recorrerCelda(cx, cy, [&](uint32_t id) { candidatos.push_back(id); });
+
+                for (size_t i = 0; i < candidatos.size(); ++i) {
+                    const Caja& ci = cajas[candidatos[i]];
+                    for (size_t j = i + 1; j < candidatos.size(); ++j) {
+                        const Caja& cj = cajas[candidatos[j]];
+                        if (!ci.intersecta(cj)) continue;
+                        if (!esCeldaDeReferencia(cx, cy, ci, cj)) continue;
+                        if (seSolapan(figuras[candidatos[i]], figuras[candidatos[j]])) {
+                            funcion(min(candidatos[i], candidatos[j]), max(candidatos[i], candidatos[j]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+// =================== BENCHMARK ===================
+
+// Figuras aleatorias con densidad constante: el mundo crece con n
+vector<FiguraPosicionada> generarFiguras(size_t n, double ladoMundo, unsigned semilla) {
+    mt19937 rng(semilla);
+    uniform_real_distribution<double> pos(0.0, ladoMundo);
+    uniform_real_distribution<double> medida(0.5, 4.0);
+    uniform_int_distribution<int> tipo(0, 2);
+
+    vector<FiguraPosicionada> figuras(n);
+    for (auto& f : figuras) {
+        f = {static_cast<TipoFigura>(tipo(rng)), pos(rng), pos(rng), medida(rng), medida(rng)};
+    }
+    return figuras;
+}
+
+size_t paresFuerzaBruta(const vector<FiguraPosicionada>& figuras, size_t limite) {
+    size_t pares = 0;
+    for (size_t i = 0; i < limite; ++i)
+        for (size_t j = i + 1; j < limite; ++j)
+            if (seSolapan(figuras[i], figuras[j])) pares++;
+    return pares;
+}
+
+void benchmark(size_t n) {
+    using reloj = chrono::steady_clock;
+    auto ms = [](reloj::time_point a, reloj::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+
+    double ladoMundo = sqrt(static_cast<double>(n)) * 8.0;
+    Caja mundo = {0, 0, ladoMundo, ladoMundo};
+    vector<FiguraPosicionada> figuras = generarFiguras(n, ladoMundo, 42);
+    cout << "Figuras: " << n << ", mundo " << ladoMundo << " x " << ladoMundo << endl;
+
+    // Verificación con un subconjunto pequeño: la rejilla debe coincidir con fuerza bruta
+    {
+        const size_t M = min<size_t>(n, 3000);
+        double ladoMuestra = sqrt(static_cast<double>(M)) * 8.0;
+        vector<FiguraPosicionada> muestra = generarFiguras(M, ladoMuestra, 1);
+        IndiceEspacial indice({0, 0, ladoMuestra, ladoMuestra}, 8.0);
+        indice.construir(muestra);
+        size_t paresRejilla = 0;
+        indice.paresSolapados([&](uint32_t, uint32_t) { paresRejilla++; });
+        size_t paresBruta = paresFuerzaBruta(muestra, M);
+        cout << "Verificación (" << M << " figuras): rejilla=" << paresRejilla
+             << " fuerza bruta=" << paresBruta
+             << (paresRejilla == paresBruta ? " OK" : " ERROR") << endl;
+    }
+
+    IndiceEspacial indice(mundo, 8.0);
+    auto t0 = reloj::now();
+    indice.construir(figuras);
+    auto t1 = reloj::now();
+    cout << "Construcción masiva: " << ms(t0, t1) << " ms" << endl;
+
+    size_t pares = 0;
+    t0 = reloj::now();
+    indice.paresSolapados([&](uint32_t, uint32_t) { pares++; });
+    t1 = reloj::now();
+    double msRejilla = ms(t0, t1);
+    cout << "Pares solapados (rejilla): " << pares << " en " << msRejilla << " ms" << endl;
+
+    // Consultas de región de 50 x 50
+    mt19937 rng(7);
+    uniform_real_distribution<double> pos(0.0, ladoMundo - 50.0);
+    vector<uint32_t> resultado;
+    size_t encontradas = 0;
+    const int CONSULTAS = 10000;
+    t0 = reloj::now();
+    for (int i = 0; i < CONSULTAS; ++i) {
+        double x = pos(rng), y = pos(rng);
+        indice.consultarRegion({x, y, x + 50, y + 50}, resultado);
+        encontradas += resultado.size();
+    }
+    t1 = reloj::now();
+    cout << "Consultas de región: " << ms(t0, t1) * 1000.0 / CONSULTAS << " us/consulta ("
+         << encontradas / CONSULTAS << " figuras en promedio)" << endl;
+
+    // Inserción incremental
+    vector<FiguraPosicionada> extra = generarFiguras(100000, ladoMundo, 9);
+    t0 = reloj::now();
+    for (const auto& f : extra) indice.insertar(f);
+    t1 = reloj::now();
+    cout << "Inserción incremental: " << ms(t0, t1) * 1e6 / extra.size() << " ns/figura" << endl;
+
+    // Fuerza bruta O(n^2): se mide sobre una muestra y se extrapola
+    const size_t M = min<size_t>(n, 20000);
+    t0 = reloj::now();
+    volatile size_t paresMuestra = paresFuerzaBruta(figuras, M);
+    t1 = reloj::now();
+    (void)paresMuestra;
+    double escala = (static_cast<double>(n) / M) * (static_cast<double>(n) / M);
+    double msBruta = ms(t0, t1) * escala;
+    cout << "Pares solapados (fuerza bruta O(n^2)): " << msBruta << " ms"
+         << (M < n ? " (estimado a partir de " + to_string(M) + " figuras)" : string()) << endl;
+    cout << "Aceleración: " << msBruta / msRejilla << "x" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        if (argc > 2) {
+            benchmark(strtoull(argv[2], nullptr, 10));
+        } else {
+            benchmark(1000000);
+            cout << endl;
+            benchmark(10000000);
+        }
+        return 0;
+    }
+
+    IndiceEspacial indice({0, 0, 100, 100}, 10.0);
+    indice.construir({
+        FiguraPosicionada::circulo(10, 10, 5.0),
+        FiguraPosicionada::cuadrado(16, 10, 4.0),
+        FiguraPosicionada::triangulo(50, 50, 6.0, 3.0),
+        FiguraPosicionada::circulo(80, 80, 2.0)
+    });
+    indice.insertar(FiguraPosicionada::cuadrado(52, 51, 2.0));
+
+    cout << "Figuras en el índice: " << indice.size() << endl;
+
+    cout << "Pares que se solapan:" << endl;
+    indice.paresSolapados([](uint32_t a, uint32_t b) {
+        cout << "  figura " << a << " y figura " << b << endl;
+    });
+
+    vector<uint32_t> resultado;
+    indice.consultarRegion({40, 40, 60, 60}, resultado);
+    cout << "Figuras en la región (40,40)-(60,60):";
+    for (uint32_t id : resultado) cout << " " << id;
+    cout << endl;
+
+    return 0;
+}
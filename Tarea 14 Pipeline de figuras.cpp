@@ -0,0 +1,306 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+using namespace std;
+
+// Pipeline de figuras en tres etapas, cada una en su propio hilo:
+//
+//   lector (parseo) --> calculador (áreas por lotes) --> escritor (formato y salida)
+//
+// Entrada: una figura por línea, con los nombres de la fábrica de la Tarea 07:
+//   circulo <radio>
+//   cuadro <lado>
+//   triangulo <base> <altura>
+// Las líneas vacías y las que empiezan con '#' se ignoran.
+//
+// Los lotes circulan entre etapas por colas acotadas y se reciclan por una cola
+// de lotes libres, así que la memoria queda fija sin importar el tamaño de la
+// entrada: si el escritor es lento, el lector se bloquea (backpressure).
+
+enum TipoFigura {
+    CIRCULO,
+    CUADRO,
+    TRIANGULO
+};
+
+struct Figura {
+    TipoFigura tipo;
+    double a;
+    double b;
+};
+
+struct Lote {
+    vector<Figura> figuras;
+    vector<double> areas;
+};
+
+// Cola bloqueante con capacidad máxima
+template <typename T>
+class ColaAcotada {
+private:
+    deque<T> elementos;
+    size_t capacidad;
+    bool cerrada;
+    mutex mtx;
+    condition_variable noVacia;
+    condition_variable noLlena;
+
+public:
+    ColaAcotada(size_t cap) : capacidad(cap), cerrada(false) {}
+
+    // Bloquea mientras la cola esté llena
+    void push(T valor) {
+        unique_lock<mutex> lock(mtx);
+        noLlena.wait(lock, [this]() { return elementos.size() < capacidad; });
+        elementos.push_back(std::move(valor));
+        noVacia.notify_one();
+    }
+
+    // Devuelve false cuando la cola está cerrada y vacía
+    bool pop(T& valor) {
+        unique_lock<mutex> lock(mtx);
+        noVacia.wait(lock, [this]() { return !elementos.empty() || cerrada; });
+        if (elementos.empty()) return false;
+        valor = std::move(elementos.front());
+        elementos.pop_front();
+        noLlena.notify_one();
+        return true;
+    }
+
+    void cerrar() {
+        lock_guard<mutex> lock(mtx);
+        cerrada = true;
+        noVacia.notify_all();
+    }
+};
+
+// Convierte una línea en figura; devuelve false si la línea no es válida
+// (medidas negativas, nan/inf o texto sobrante)
+bool parsearFigura(const char* linea, Figura& figura) {
+    char nombre[16];
+    int leidos = 0;
+    if (sscanf(linea, "%15s%n", nombre, &leidos) != 1) return false;
+
+    char* fin;
+    const char* resto = linea + leidos;
+    figura.a = strtod(resto, &fin);
+    if (fin == resto || !isfinite(figura.a) || figura.a < 0) return false;
+    figura.b = 0;
+
+    if (strcmp(nombre, "circulo") == 0) {
+        figura.tipo = CIRCULO;
+    } else if (strcmp(nombre, "cuadro") == 0) {
+        figura.tipo = CUADRO;
+    } else if (strcmp(nombre, "triangulo") == 0) {
+        figura.tipo = TRIANGULO;
+        const char* inicioB = fin;
+        figura.b = strtod(inicioB, &fin);
+        if (fin == inicioB || !isfinite(figura.b) || figura.b < 0) return false;
+    } else {
+        return false;
+    }
+    while (isspace(static_cast<unsigned char>(*fin))) fin++;
+    return *fin == '\0';
+}
+
+class PipelineFiguras {
+private:
+    size_t tamLote;
+    size_t capacidadCola;
+
+    ColaAcotada<Lote*> libres;
+    ColaAcotada<Lote*> parseados;
+    ColaAcotada<Lote*> calculados;
+    vector<Lote> lotes;
+
+    size_t totalFiguras;
+    size_t lineasInvalidas;
+
+    void etapaLectura(const vector<string>& archivos) {
+        Lote* lote = nullptr;
+        libres.pop(lote);
+
+        auto leer = [&](istream& entrada, const string& nombre) {
+            string linea;
+            size_t numero = 0;
+            while (getline(entrada, linea)) {
+                numero++;
+                if (linea.empty() || linea[0] == '#') continue;
+
+                Figura figura;
+                if (!parsearFigura(linea.c_str(), figura)) {
+                    lineasInvalidas++;
+                    cerr << nombre << ":" << numero << ": línea inválida: " << linea << endl;
+                    continue;
+                }
+                lote->figuras.push_back(figura);
+                if (lote->figuras.size() == tamLote) {
+                    parseados.push(lote);
+                    libres.pop(lote);
+                }
+            }
+        };
+
+        if (archivos.empty()) {
+            leer(cin, "stdin");
+        }
+        for (const string& archivo : archivos) {
+            if (archivo == "-") {
+                leer(cin, "stdin");
+                continue;
+            }
+            ifstream entrada(archivo);
+            if (!entrada.is_open()) {
+                cerr << "Error: No se pudo abrir " << archivo << endl;
+                continue;
+            }
+            leer(entrada, archivo);
+        }
+
+        if (!lote->figuras.empty()) parseados.push(lote);
+        parseados.cerrar();
+    }
+
+    void etapaCalculo() {
+        Lote* lote;
+        while (parseados.pop(lote)) {
+            const vector<Figura>& figuras = lote->figuras;
+            lote->areas.resize(figuras.size());
+            for (size_t i = 0; i < figuras.size(); ++i) {
+                const Figura& f = figuras[i];
+                switch (f.tipo) {
+                    case CIRCULO:  lote->areas[i] = M_PI * f.a * f.a; break;
+                    case CUADRO:   lote->areas[i] = f.a * f.a; break;
+                    default:       lote->areas[i] = (f.a * f.b) / 2.0; break;
+                }
+            }
+            calculados.push(lote);
+        }
+        calculados.cerrar();
+    }
+
+    void etapaEscritura(FILE* salida) {
+        static const char* nombres[] = {"circulo", "cuadro", "triangulo"};
+        string buffer;
+
+        Lote* lote;
+        while (calculados.pop(lote)) {
+            buffer.clear();
+            for (size_t i = 0; i < lote->figuras.size(); ++i) {
+                // Se formatea directo en el buffer; las áreas enormes (con
+                // %.4f pueden pasar de 300 caracteres) se formatean de nuevo
+                // con el largo exacto
+                const char* nombre = nombres[lote->figuras[i].tipo];
+                size_t inicio = buffer.size();
+                size_t espacio = 64;
+                buffer.resize(inicio + espacio);
+                int n = snprintf(&buffer[inicio], espacio, "%s %.4f\n", nombre, lote->areas[i]);
+                if (n >= static_cast<int>(espacio)) {
+                    buffer.resize(inicio + n + 1);
+                    snprintf(&buffer[inicio], n + 1, "%s %.4f\n", nombre, lote->areas[i]);
+                }
+                buffer.resize(inicio + max(n, 0));
+            }
+            fwrite(buffer.data(), 1, buffer.size(), salida);
+            totalFiguras += lote->figuras.size();
+
+            lote->figuras.clear();
+            libres.push(lote);
+        }
+        fflush(salida);
+    }
+
+public:
+    // Lotes en total: las dos colas llenas más uno en manos de cada etapa
+    PipelineFiguras(size_t lote = 4096, size_t cola = 8)
+        : tamLote(max<size_t>(1, lote)), capacidadCola(max<size_t>(1, cola)),
+          libres(2 * capacidadCola + 3), parseados(capacidadCola), calculados(capacidadCola),
+          lotes(2 * capacidadCola + 3), totalFiguras(0), lineasInvalidas(0) {
+        for (Lote& l : lotes) {
+            l.figuras.reserve(tamLote);
+            l.areas.reserve(tamLote);
+            libres.push(&l);
+        }
+    }
+
+    void ejecutar(const vector<string>& archivos, FILE* salida) {
+        auto inicio = chrono::steady_clock::now();
+
+        thread lector(&PipelineFiguras::etapaLectura, this, cref(archivos));
+        thread calculador(&PipelineFiguras::etapaCalculo, this);
+        etapaEscritura(salida);
+
+        lector.join();
+        calculador.join();
+
+        auto fin = chrono::steady_clock::now();
+        double segundos = chrono::duration<double>(fin - inicio).count();
+        cerr << "Figuras procesadas: " << totalFiguras
+             << ", líneas inválidas: " << lineasInvalidas
+             << ", tiempo: " << segundos << " s"
+             << ", rendimiento: " << (segundos > 0 ? totalFiguras / segundos : 0) << " figuras/s"
+             << endl;
+    }
+};
+
+// Genera n figuras aleatorias en el formato de entrada (para pruebas de rendimiento)
+void generarEntrada(size_t n) {
+    mt19937 rng(42);
+    uniform_real_distribution<double> medida(0.5, 10.0);
+    uniform_int_distribution<int> tipo(0, 2);
+    for (size_t i = 0; i < n; ++i) {
+        switch (tipo(rng)) {
+            case 0:  printf("circulo %.3f\n", medida(rng)); break;
+            case 1:  printf("cuadro %.3f\n", medida(rng)); break;
+            default: printf("triangulo %.3f %.3f\n", medida(rng), medida(rng)); break;
+        }
+    }
+}
+
+void mostrarUso(const char* programa) {
+    cerr << "Uso: " << programa << " [--lote N] [--cola N] [archivo ...]\n"
+         << "     " << programa << " --generar N\n"
+         << "Sin archivos (o con '-') se lee de la entrada estándar.\n";
+}
+
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+
+    size_t lote = 4096;
+    size_t cola = 8;
+    vector<string> archivos;
+
+    for (int i = 1; i < argc; ++i) {
+        string opcion = argv[i];
+        if ((opcion == "--lote" || opcion == "--cola" || opcion == "--generar") && i + 1 < argc) {
+            size_t valor = strtoull(argv[++i], nullptr, 10);
+            if (opcion == "--generar") {
+                generarEntrada(valor);
+                return 0;
+            }
+            (opcion == "--lote" ? lote : cola) = valor;
+        } else if (opcion == "--help" || opcion == "-h") {
+            mostrarUso(argv[0]);
+            return 0;
+        } else {
+            archivos.push_back(opcion);
+        }
+    }
+
+    PipelineFiguras pipeline(lote, cola);
+    pipeline.ejecutar(archivos, stdout);
+    return 0;
+}
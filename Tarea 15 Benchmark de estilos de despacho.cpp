@@ -0,0 +1,440 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Benchmark: la misma carga de trabajo (sumar el área de N figuras) usando
+// cada uno de los estilos de cálculo que hay en el repositorio:
+//   act1     funciones libres
+//   act2     clases concretas
+//   act3     clases concretas con área memorizada
+//   act4     clase base abstracta, llamadas virtuales con área memorizada
+//   tarea07  fábrica que devuelve unique_ptr, llamadas virtuales sin memorizar
+// Se mide con los tipos ordenados (predicción de saltos fácil) y mezclados.
+
+enum TipoFigura {
+    CIRCULO,
+    CUADRADO,
+    TRIANGULO
+};
+
+struct Especificacion {
+    TipoFigura tipo;
+    double a;
+    double b;
+};
+
+// =================== ESTILOS ===================
+
+namespace estilo_act1 {
+    double areaCirculo(double radio) { return M_PI * radio * radio; }
+    double areaCuadrado(double lado) { return lado * lado; }
+    double areaTriangulo(double base, double altura) { return (base * altura) / 2.0; }
+}
+
+namespace estilo_act2 {
+    class Circulo {
+        double radio;
+    public:
+        Circulo(double r) : radio(r) {}
+        double calcularArea() { return M_PI * radio * radio; }
+    };
+    class Cuadrado {
+        double lado;
+    public:
+        Cuadrado(double l) : lado(l) {}
+        double calcularArea() { return lado * lado; }
+    };
+    class Triangulo {
+        double base, altura;
+    public:
+        Triangulo(double b, double h) : base(b), altura(h) {}
+        double calcularArea() { return (base * altura) / 2.0; }
+    };
+}
+
+namespace estilo_act3 {
+    class Circulo {
+        double radio, area;
+        bool areaCalculada;
+    public:
+        Circulo(double r) : radio(r), area(0), areaCalculada(false) {}
+        double calcularArea() {
+            if (!areaCalculada) {
+                area = M_PI * radio * radio;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+    class Cuadrado {
+        double lado, area;
+        bool areaCalculada;
+    public:
+        Cuadrado(double l) : lado(l), area(0), areaCalculada(false) {}
+        double calcularArea() {
+            if (!areaCalculada) {
+                area = lado * lado;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+    class Triangulo {
+        double base, altura, area;
+        bool areaCalculada;
+    public:
+        Triangulo(double b, double h) : base(b), altura(h), area(0), areaCalculada(false) {}
+        double calcularArea() {
+            if (!areaCalculada) {
+                area = (base * altura) / 2.0;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+}
+
+namespace estilo_act4 {
+    class FiguraGeometrica {
+    public:
+        virtual double calcularArea() = 0;
+        virtual ~FiguraGeometrica() {}
+    };
+    class Circulo : public FiguraGeometrica {
+        double radio, area;
+        bool areaCalculada;
+    public:
+        Circulo(double r) : radio(r), area(0), areaCalculada(false) {}
+        double calcularArea() override {
+            if (!areaCalculada) {
+                area = M_PI * radio * radio;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+    class Cuadrado : public FiguraGeometrica {
+        double lado, area;
+        bool areaCalculada;
+    public:
+        Cuadrado(double l) : lado(l), area(0), areaCalculada(false) {}
+        double calcularArea() override {
+            if (!areaCalculada) {
+                area = lado * lado;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+    class Triangulo : public FiguraGeometrica {
+        double base, altura, area;
+        bool areaCalculada;
+    public:
+        Triangulo(double b, double h) : base(b), altura(h), area(0), areaCalculada(false) {}
+        double calcularArea() override {
+            if (!areaCalculada) {
+                area = (base * altura) / 2.0;
+                areaCalculada = true;
+            }
+            return area;
+        }
+    };
+}
+
+namespace estilo_tarea07 {
+    class FiguraGeometrica {
+    public:
+        virtual double area() = 0;
+        virtual ~FiguraGeometrica() {}
+    };
+    class Circulo : public FiguraGeometrica {
+        double radio;
+    public:
+        Circulo(double r) : radio(r) {}
+        double area() override { return 3.1416 * radio * radio; }
+    };
+    class Cuadro : public FiguraGeometrica {
+        double lado;
+    public:
+        Cuadro(double l) : lado(l) {}
+        double area() override { return lado * lado; }
+    };
+    class Triangulo : public FiguraGeometrica {
+        double base, altura;
+    public:
+        Triangulo(double b, double h) : base(b), altura(h) {}
+        double area() override { return (base * altura) / 2; }
+    };
+    class FiguraFactory {
+    public:
+        static unique_ptr<FiguraGeometrica> crearFigura(const string& tipo, double a, double b = 0) {
+            if (tipo == "circulo") {
+                return make_unique<Circulo>(a);
+            } else if (tipo == "cuadro") {
+                return make_unique<Cuadro>(a);
+            } else if (tipo == "triangulo") {
+                return make_unique<Triangulo>(a, b);
+            } else {
+                return nullptr;
+            }
+        }
+    };
+}
+
+// =================== CONTADORES DE HARDWARE ===================
+
+// Contadores de perf_event_open (Linux). Si el kernel o el contenedor no los
+// permiten, disponible() devuelve false y solo se reporta el tiempo.
+class ContadoresHardware {
+private:
+    static const int NUM = 3;
+    int fds[NUM];
+    bool ok;
+
+#ifdef __linux__
+    static int abrir(uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+public:
+    ContadoresHardware() : ok(false) {
+        for (int i = 0; i < NUM; ++i) fds[i] = -1;
+#ifdef __linux__
+        const uint64_t configs[NUM] = {
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_MISSES
+        };
+        ok = true;
+        for (int i = 0; i < NUM; ++i) {
+            fds[i] = abrir(configs[i]);
+            if (fds[i] < 0) ok = false;
+        }
+#endif
+    }
+
+    ~ContadoresHardware() {
+#ifdef __linux__
+        for (int fd : fds) if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool disponible() const { return ok; }
+
+    void iniciar() {
+#ifdef __linux__
+        if (!ok) return;
+        for (int fd : fds) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // instrucciones, fallos de predicción de saltos, fallos de caché
+    void detener(uint64_t valores[NUM]) {
+        for (int i = 0; i < NUM; ++i) valores[i] = 0;
+#ifdef __linux__
+        if (!ok) return;
+        for (int i = 0; i < NUM; ++i) {
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], &valores[i], sizeof(uint64_t)) != sizeof(uint64_t)) valores[i] = 0;
+        }
+#endif
+    }
+};
+
+// =================== BENCHMARK ===================
+
+class BenchmarkDespacho {
+private:
+    size_t n;
+    int pasadas;
+    ContadoresHardware contadores;
+    volatile double sumidero;
+
+    void reportar(const string& estilo, const string& mezcla, double ns, const uint64_t v[3]) {
+        double total = static_cast<double>(n) * pasadas;
+        cout << left << setw(10) << estilo << setw(11) << mezcla << right << fixed
+             << setprecision(2) << setw(10) << ns / total;
+        if (contadores.disponible()) {
+            cout << setw(12) << v[0] / total << setw(14) << v[1] / total
+                 << setw(16) << v[2] / total;
+        } else {
+            cout << setw(12) << "n/d" << setw(14) << "n/d" << setw(16) << "n/d";
+        }
+        cout << endl;
+    }
+
+    // Ejecuta la función 'pasada' varias veces y mide tiempo y contadores
+    template <typename Pasada>
+    void medir(const string& estilo, const string& mezcla, Pasada&& pasada) {
+        pasada(); // calentamiento (y primer cálculo en los estilos memorizados)
+        uint64_t valores[3];
+        contadores.iniciar();
+        auto inicio = chrono::steady_clock::now();
+        double suma = 0;
+        for (int p = 0; p < pasadas; ++p) suma += pasada();
+        auto fin = chrono::steady_clock::now();
+        contadores.detener(valores);
+        sumidero = suma;
+        reportar(estilo, mezcla, chrono::duration<double, nano>(fin - inicio).count(), valores);
+    }
+
+public:
+    BenchmarkDespacho(size_t figuras, int repeticiones)
+        : n(figuras), pasadas(repeticiones), sumidero(0) {}
+
+    void ejecutar(const vector<Especificacion>& specs, const string& mezcla) {
+        // act1: funciones libres, despacho con switch
+        medir("act1", mezcla, [&]() {
+            double suma = 0;
+            for (const Especificacion& s : specs) {
+                switch (s.tipo) {
+                    case CIRCULO:  suma += estilo_act1::areaCirculo(s.a); break;
+                    case CUADRADO: suma += estilo_act1::areaCuadrado(s.a); break;
+                    default:       suma += estilo_act1::areaTriangulo(s.a, s.b); break;
+                }
+            }
+            return suma;
+        });
+
+        // act2 / act3: objetos concretos en arreglos por tipo + (tipo, índice)
+        auto medirConcretos = [&](const string& estilo, auto circulo, auto cuadrado, auto triangulo) {
+            using C = decltype(circulo);
+            using Q = decltype(cuadrado);
+            using T = decltype(triangulo);
+            vector<C> circulos;
+            vector<Q> cuadrados;
+            vector<T> triangulos;
+            vector<pair<TipoFigura, uint32_t>> orden;
+            orden.reserve(specs.size());
+            for (const Especificacion& s : specs) {
+                if (s.tipo == CIRCULO) {
+                    orden.emplace_back(CIRCULO, circulos.size());
+                    circulos.emplace_back(s.a);
+                } else if (s.tipo == CUADRADO) {
+                    orden.emplace_back(CUADRADO, cuadrados.size());
+                    cuadrados.emplace_back(s.a);
+                } else {
+                    orden.emplace_back(TRIANGULO, triangulos.size());
+                    triangulos.emplace_back(s.a, s.b);
+                }
+            }
+            medir(estilo, mezcla, [&]() {
+                double suma = 0;
+                for (const auto& o : orden) {
+                    switch (o.first) {
+                        case CIRCULO:  suma += circulos[o.second].calcularArea(); break;
+                        case CUADRADO: suma += cuadrados[o.second].calcularArea(); break;
+                        default:       suma += triangulos[o.second].calcularArea(); break;
+                    }
+                }
+                return suma;
+            });
+        };
+        medirConcretos("act2", estilo_act2::Circulo(0), estilo_act2::Cuadrado(0),
+                       estilo_act2::Triangulo(0, 0));
+        medirConcretos("act3", estilo_act3::Circulo(0), estilo_act3::Cuadrado(0),
+                       estilo_act3::Triangulo(0, 0));
+
+        // act4: punteros a la clase base, llamadas virtuales
+        {
+            using namespace estilo_act4;
+            vector<FiguraGeometrica*> figuras;
+            figuras.reserve(specs.size());
+            for (const Especificacion& s : specs) {
+                if (s.tipo == CIRCULO) figuras.push_back(new Circulo(s.a));
+                else if (s.tipo == CUADRADO) figuras.push_back(new Cuadrado(s.a));
+                else figuras.push_back(new Triangulo(s.a, s.b));
+            }
+            medir("act4", mezcla, [&]() {
+                double suma = 0;
+                for (FiguraGeometrica* f : figuras) suma += f->calcularArea();
+                return suma;
+            });
+            for (FiguraGeometrica* f : figuras) delete f;
+        }
+
+        // tarea07: fábrica con unique_ptr, llamadas virtuales
+        {
+            using namespace estilo_tarea07;
+            static const string nombres[] = {"circulo", "cuadro", "triangulo"};
+            vector<unique_ptr<FiguraGeometrica>> figuras;
+            figuras.reserve(specs.size());
+            for (const Especificacion& s : specs) {
+                figuras.push_back(FiguraFactory::crearFigura(nombres[s.tipo], s.a, s.b));
+            }
+            medir("tarea07", mezcla, [&]() {
+                double suma = 0;
+                for (auto& f : figuras) suma += f->area();
+                return suma;
+            });
+        }
+    }
+
+    void ejecutarTodo(unsigned semilla) {
+        mt19937 rng(semilla);
+        uniform_real_distribution<double> medida(0.5, 10.0);
+        uniform_int_distribution<int> tipo(0, 2);
+
+        vector<Especificacion> specs(n);
+        for (auto& s : specs) {
+            s = {static_cast<TipoFigura>(tipo(rng)), medida(rng), medida(rng)};
+        }
+
+        cout << "Figuras: " << n << ", pasadas: " << pasadas << endl;
+        if (!contadores.disponible()) {
+            cout << "perf_event_open no disponible: solo se reporta el tiempo" << endl;
+        }
+        cout << left << setw(10) << "estilo" << setw(11) << "mezcla" << right
+             << setw(10) << "ns/area" << setw(12) << "instr/area"
+             << setw(14) << "br-miss/area" << setw(16) << "cache-miss/area" << endl;
+
+        ejecutar(specs, "mezclada");
+
+        stable_sort(specs.begin(), specs.end(),
+                    [](const Especificacion& x, const Especificacion& y) { return x.tipo < y.tipo; });
+        ejecutar(specs, "ordenada");
+    }
+};
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int pasadas = argc > 2 ? atoi(argv[2]) : 10;
+    if (n == 0 || pasadas <= 0) {
+        cerr << "Uso: " << argv[0] << " [figuras] [pasadas]" << endl;
+        return 1;
+    }
+
+    BenchmarkDespacho benchmark(n, pasadas);
+    benchmark.ejecutarTodo(42);
+    return 0;
+}